@@ -1,9 +1,10 @@
 #include "AIShell.h"
-#include "LineCounter.h"
+#include "ThreadPool.h"
 #include <algorithm>
 #include <chrono>
 #include <iostream>
-#include <random>
+#include <memory>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -14,555 +15,231 @@ using namespace std::chrono;
 
 namespace {
 static const bool DEBUG = false;
-static const std::chrono::milliseconds TIME_MARGIN{0};
 
-std::random_device rd;
-std::mt19937 rng(rd()); // rng to return random move when no best move found
+// Share of the time left that the solver may use before the search takes
+// over.
+static const int SOLVE_SHARE = 4;
 
-static const int MAXWIN = 1000;
-static const int MINWIN = -1000;
-
-// Store the last best move chain statically since AIShell is destroyed each
-// turn.
-// Kludgy- it would be better if the history could be stored inside AIShell.
-MovesList lastMoves = {};
+// With --engine=auto, boards without gravity of at least this many cells are
+// searched by MCTS.
+static const int AUTO_MCTS_CELLS = 100;
 } // namespace
-inline const milliseconds currentTime() {
-  return duration_cast<milliseconds>(system_clock::now().time_since_epoch());
-}
-
-inline LineCounter::LineCounter(int k) : k{k} {}
-
-inline int LineCounter::winsInLine(int lineLength) const {
-  return (lineLength >= k) ? (lineLength - k + 1) : 0;
-}
-
-inline int LineCounter::possibleWinsInLine(int lineLength) const {
-  return winsInLine(lineLength);
-}
-
-inline void LineCounter::pushContiguous() {
-  minWins += winsInLine(minContiguousStreak);
-  maxWins += winsInLine(maxContiguousStreak);
-  minContiguousStreak = 0;
-  maxContiguousStreak = 0;
-}
-
-inline void LineCounter::pushMax() {
-  maxWins += winsInLine(maxContiguousStreak);
-  maxPossibleWins += possibleWinsInLine(maxOpenStreak);
-  maxOpenStreak = 0;
-  maxContiguousStreak = 0;
-}
-
-inline void LineCounter::pushMin() {
-  minWins += winsInLine(minContiguousStreak);
-  minPossibleWins += possibleWinsInLine(minOpenStreak);
-  minOpenStreak = 0;
-  minContiguousStreak = 0;
-}
-
-inline void LineCounter::pushLine() {
-  minWins += winsInLine(minContiguousStreak);
-  maxWins += winsInLine(maxContiguousStreak);
-  minPossibleWins += possibleWinsInLine(minOpenStreak);
-  maxPossibleWins += possibleWinsInLine(maxOpenStreak);
-  minOpenStreak = 0;
-  maxOpenStreak = 0;
-  minContiguousStreak = 0;
-  maxContiguousStreak = 0;
-}
-
-inline void LineCounter::addPiece(int piece) {
-  switch (piece) {
-  case AIShell::NO_PIECE:
-    minOpenStreak++;
-    maxOpenStreak++;
-    pushContiguous();
-    break;
-  case AIShell::OPPONENT_PIECE:
-    minOpenStreak++;
-    minContiguousStreak++;
-    pushMax();
-    break;
-  case AIShell::PLAYER_PIECE:
-    maxOpenStreak++;
-    maxContiguousStreak++;
-    pushMin();
-    break;
-  default:
-    break;
-  }
-}
-
-AIShell::AIShell(bool gravityOn, int numCols, int numRows, int k,
-                 int **gameState, Move lastMove, int deadline)
-    : gravityOn{gravityOn}, numCols{numCols}, numRows{numRows}, k{k},
-      gameState{gameState}, lastMove{lastMove}, deadline{deadline} {}
-
-AIShell::~AIShell() {
-  // delete the gameState variable.
-  for (int i = 0; i < numCols; i++) {
-    delete[] gameState[i];
-  }
-  delete[] gameState;
-}
-
-inline bool AIShell::timeLeft() const { return currentTime() < stopTime; }
-
-inline void AIShell::checkTime() {
-  if (!timeLeft()) {
-    outOfTime = true;
-  }
-}
-
-inline const Coord AIShell::dropPiece(const int col) const {
-  for (int row = 0; row < numRows; row++) {
-    if (gameState[col][row] == NO_PIECE) {
-      return {col, row};
-    }
-  }
-  if (DEBUG) {
-    cout << "dropPiece: Invalid column specified: index " << col << endl;
-  }
-  return {-1, -1}; // Make sure we never get here
-}
-
-inline bool AIShell::colHasSpace(const int col) const {
-
-  if (col < 0 or col > (numCols - 1)) {
-    if (DEBUG) {
-      cout << "colHasSpace: Invalid column specified: index " << col << endl;
-    }
-    return false;
-  }
-  return gameState[col][numRows - 1] == NO_PIECE;
-}
-
-inline bool AIShell::colNotEmpty(const int col) const {
-  return gameState[col][0] != NO_PIECE;
-}
-
-inline bool AIShell::notInMoves(const Coord move) const {
-  return find(moves.begin(), moves.end(), move) == moves.end();
-}
-
-inline void AIShell::findMoves() {
-  moves = {};
 
-  for (auto move : lastMoves) {
-    if (gravityOn) { // Prioritize columns from lastMoves
-      if (colHasSpace(move.first) and notInMoves(dropPiece(move.first))) {
-        moves.push_back(dropPiece(move.first));
-      }
-    } else if (!gravityOn) { // Prioritize moves from lastMoves
-      if (gameState[move.first][move.second] == NO_PIECE and notInMoves(move)) {
-        moves.push_back(move);
-      }
-    }
-  }
-
-  // lastMoves.clear();
-
-  if (gravityOn) { // Prioritize moves in non-empty columns & their neighbors
-    for (int col = 0; col < numCols; col++) {
-      if (colNotEmpty(col)) {
-        for (int col2 = max(0, col - 1); col2 <= min(col + 1, numCols - 1);
-             col2++) {
-          if (colHasSpace(col2) and notInMoves(dropPiece(col2))) {
-            moves.push_back(dropPiece(col2));
-          }
-        }
-      }
-    }
-  } else if (!gravityOn) { // Prioritize moves around existing pieces
-    for (int col = 0; col < numCols; col++) {
-      for (int row = 0; row < numRows; row++) {
-        if (gameState[col][row] != NO_PIECE) {
-          for (int x = max(0, col - 1); x <= min(col + 1, numCols - 1); x++) {
-            if (gameState[x][row] == NO_PIECE and notInMoves({x, row})) {
-              moves.push_back({x, row});
-            }
-          }
-          for (int y = max(0, row - 1); y <= min(row + 1, numRows - 1); y++) {
-            if (gameState[col][y] == NO_PIECE and notInMoves({col, y})) {
-              moves.push_back({col, y});
-            }
-          }
-          for (int x = max(0, col - 1), y = max(0, row - 1);
-               x <= min(col + 1, numCols - 1) and
-               y <= min(row + 1, numRows - 1);
-               x++, y++) {
-            if (gameState[x][y] == NO_PIECE and notInMoves({x, y})) {
-              moves.push_back({x, y});
-            }
-          }
-          for (int x = max(0, col - 1), y = min(row + 1, numRows - 1);
-               x <= min(col + 1, numCols - 1) and y >= max(0, row - 1);
-               x++, y--) {
-            if (gameState[x][y] == NO_PIECE and notInMoves({x, y})) {
-              moves.push_back({x, y});
-            }
-          }
-        }
+AIShell::AIShell(const SearchOptions &options)
+    : options{options}, tt{options.hashSizeMb} {}
+
+AIShell::~AIShell() { stopPondering(); }
+
+void AIShell::setState(bool gravityOn, int numCols, int numRows, int k,
+                       const vector<int> &cells, Move lastMove,
+                       int deadline) {
+  requestTime = Clock::now();
+  const bool sameRules = board and gravityOn == this->gravityOn and
+                         numCols == this->numCols and
+                         numRows == this->numRows and k == this->k;
+  this->gravityOn = gravityOn;
+  this->numCols = numCols;
+  this->numRows = numRows;
+  this->k = k;
+  this->lastMove = lastMove;
+  this->deadline = deadline;
+
+  const int pondered = ponderCell;
+  ponderCell = -1;
+  ponderHit = false;
+  if (sameRules and continuesGame(cells)) {
+    const int replyCell = board->cell(lastMove.col, lastMove.row);
+    if (replyCell == pondered) {
+      // The searchers are already there; makeMove lets them run on.
+      if (DEBUG) {
+        cout << "Ponder hit." << endl;
       }
+      board->place(replyCell, OPPONENT_PIECE);
+      ponderHit = true;
+      return;
     }
-  }
-
-  if (gravityOn) { // Add the rest of the non-filled columns
-    for (int col = 0; col < numCols; col++) {
-      if (colHasSpace(col) and notInMoves(dropPiece(col))) {
-        moves.push_back(dropPiece(col));
+    stopPondering();
+    if (pondered >= 0) {
+      if (DEBUG) {
+        cout << "Ponder miss." << endl;
       }
+      takeBackOnSearchers(pondered, OPPONENT_PIECE);
+      mainSearcher->lastMoves.clear();
     }
-  } else if (!gravityOn) { // Add the rest of the pieces
-    for (int col = 0; col < numCols; col++) {
-      for (int row = 0; row < numRows; row++) {
-        if (gameState[col][row] == NO_PIECE and notInMoves({col, row})) {
-          moves.push_back({col, row});
-        }
-      }
+    play(replyCell, OPPONENT_PIECE);
+  } else {
+    if (DEBUG) {
+      cout << "Starting a new game." << endl;
     }
+    stopPondering();
+    newGame(cells);
   }
 }
 
-inline int AIShell::staticEval() const {
-  // TODO: Count k-1 in a row placed pieces with 1 empty piece
-  // TODO: Count k-2 in a row placed pieces with 2 empty pieces
-
-  // Boundaries are defined inclusively.
-
-  // This box of k around is valid for calculating a winner, but it doesn't
-  // provide valid relative overall utility scores for comparing states.
-  // It is faster than calculating the whole board; use it if the
-  // heuristic is switched out for something else.
-
-  // const int left = max(lastMove.col - (k - 1), 0),
-  //           bottom = max(lastMove.row - (k - 1), 0),
-  //           right = min(lastMove.col + (k - 1), numCols - 1),
-  //           top = min(lastMove.row + (k - 1), numRows - 1);
-
-  const int left = 0, bottom = 0, right = numCols - 1, top = numRows - 1;
-
-  LineCounter verticalCounter = LineCounter(k);
-  LineCounter horizCounter = LineCounter(k);
-  LineCounter downRightCounter = LineCounter(k);
-  LineCounter downLeftCounter = LineCounter(k);
-
-  // vertical
-  for (int x = left; x <= right; x++) {
-    for (int y = bottom; y <= top; y++) {
-      verticalCounter.addPiece(gameState[x][y]);
-    }
-    verticalCounter.pushLine();
+// Whether the request is the position after our last move plus the
+// opponent's reply, and nothing else.
+bool AIShell::continuesGame(const vector<int> &cells) const {
+  if (lastMove == Move(-1, -1) or lastMove.col < 0 or
+      lastMove.col >= numCols or lastMove.row < 0 or lastMove.row >= numRows) {
+    return false;
   }
-
-  // horizontal
-  for (int y = bottom; y <= top; y++) {
-    for (int x = left; x <= right; x++) {
-      horizCounter.addPiece(gameState[x][y]);
+  const int replyCell = board->cell(lastMove.col, lastMove.row);
+  for (int cell = 0; cell < board->numCells(); cell++) {
+    const int expected = (cell == replyCell) ? OPPONENT_PIECE
+                                             : board->pieceAt(cell);
+    if (cells[cell] != expected or
+        (cell == replyCell and !board->isEmpty(cell))) {
+      return false;
     }
-    horizCounter.pushLine();
   }
+  return true;
+}
 
-  // downright diagonal
-  for (int row = bottom + (k - 1); row <= top; row++) {
-    for (int x = left, y = row; y >= bottom and x <= right; x++, y--) {
-      downRightCounter.addPiece(gameState[x][y]);
-    }
-    downRightCounter.pushLine();
+// Forgets the previous game and sets up searchers for the new position.
+// Unless the table is cleared, its entries stay and age out.
+void AIShell::newGame(const vector<int> &cells, bool clearTable) {
+  helpers.clear();
+  mainSearcher.reset();
+  pool.reset();
+  if (clearTable) {
+    tt.clear();
   }
-  for (int col = left + 1; col <= right - (k - 1); col++) {
-    for (int y = top, x = col; y >= bottom and x <= right; x++, y--) {
-      downRightCounter.addPiece(gameState[x][y]);
+
+  board.reset(new Board(gravityOn, numCols, numRows, k));
+  for (int cell = 0; cell < board->numCells(); cell++) {
+    if (cells[cell] != NO_PIECE) {
+      board->place(cell, cells[cell]);
     }
-    downRightCounter.pushLine();
   }
 
-  // downleft diagonal
-  for (int col = left + (k - 1); col <= right; col++) {
-    for (int x = col, y = top; x >= left and y >= bottom; x--, y--) {
-      downLeftCounter.addPiece(gameState[x][y]);
-    }
-    downLeftCounter.pushLine();
+  // YBW: the other threads wait in a pool for the main search to offer
+  // them subtrees. Lazy SMP: every thread runs its own iterative deepening
+  // over the same position, sharing only the transposition table.
+  if (options.ybw and options.threads > 1) {
+    pool.reset(
+        new ThreadPool(*board, options, tt, control, options.threads - 1));
   }
-  for (int row = top - 1; row >= bottom; row--) {
-    for (int x = right, y = row; x >= left and y >= bottom; x--, y--) {
-      downLeftCounter.addPiece(gameState[x][y]);
-    }
-    downLeftCounter.pushLine();
+  mainSearcher.reset(
+      new Searcher(*board, options, tt, control, 0, pool.get()));
+  solver.reset(); // built once a position is nearly full
+  for (int i = 1; i < options.threads and !pool; i++) {
+    helpers.emplace_back(new Searcher(*board, options, tt, control, i));
   }
-
-  bool minWinner = verticalCounter.minWins or horizCounter.minWins or
-                   downLeftCounter.minWins or downRightCounter.minWins;
-  bool maxWinner = verticalCounter.maxWins or horizCounter.maxWins or
-                   downLeftCounter.maxWins or downRightCounter.maxWins;
-
-  if (minWinner) {
-    return MINWIN;
-  } else if (maxWinner) {
-    return MAXWIN;
+  const bool useMcts =
+      options.engine == SearchOptions::MCTS or
+      (options.engine == SearchOptions::AUTO and !gravityOn and
+       board->numCells() >= AUTO_MCTS_CELLS);
+  if (useMcts) {
+    mcts.reset(new MonteCarlo(*board, options, control));
   } else {
-    int maxScore =
-        verticalCounter.maxPossibleWins + horizCounter.maxPossibleWins +
-        downLeftCounter.maxPossibleWins + downRightCounter.maxPossibleWins;
-    int minScore =
-        verticalCounter.minPossibleWins + horizCounter.minPossibleWins +
-        downLeftCounter.minPossibleWins + downRightCounter.minPossibleWins;
-    return maxScore - minScore;
+    mcts.reset();
   }
 }
 
-inline const pair<MovesList, int>
-AIShell::minPlayer(const MovesList moves, const int depth, int a, int b) {
-  const int evalScore = staticEval();
-  if ((depth == 0) or (evalScore == MINWIN) or (evalScore == MAXWIN) or
-      moves.empty()) {
-    return {{}, evalScore};
+// Plays a move of the game on the board and every searcher's root.
+void AIShell::play(const int cell, const int piece) {
+  board->place(cell, piece);
+  playOnSearchers(cell, piece);
+  if (mcts) {
+    mcts->playMove(cell, piece);
   }
-
-  MovesList moveHistory = {};
-  int worstScore = MAXWIN;
-
-  for (int i = 0; i < moves.size(); i++) {
-    Coord move = moves[i];
-    gameState[move.first][move.second] = OPPONENT_PIECE;
-    MovesList newMoves = {};
-    if (gravityOn and colHasSpace(move.first)) {
-      newMoves.push_back(dropPiece(move.first));
-    }
-    for (int j = 0; j < i; j++) {
-      newMoves.push_back(moves[j]);
-    }
-    for (int j = i + 1; j < moves.size(); j++) {
-      newMoves.push_back(moves[j]);
-    }
-    MovesList childMoveHistory;
-    int stateScore;
-    tie(childMoveHistory, stateScore) = maxPlayer(newMoves, depth - 1, a, b);
-    gameState[move.first][move.second] = NO_PIECE;
-    if (stateScore < worstScore) {
-      worstScore = stateScore;
-      moveHistory.clear();
-      moveHistory.push_back(move);
-      // if (!childMoveHistory.empty()) {
-      for (auto item : childMoveHistory) {
-        moveHistory.push_back(item);
-      }
-      // }
-    }
-    b = min(stateScore, b);
-
-    checkTime();
-
-    if (a >= b or outOfTime) {
-      break;
-    }
-  }
-
-  return {moveHistory, worstScore};
 }
 
-inline const pair<MovesList, int>
-AIShell::maxPlayer(const MovesList moves, const int depth, int a, int b) {
-  const int evalScore = staticEval();
-  if ((depth == 0) or (evalScore == MINWIN) or (evalScore == MAXWIN) or
-      moves.empty()) {
-    return {{}, evalScore};
+void AIShell::playOnSearchers(const int cell, const int piece) {
+  mainSearcher->playMove(cell, piece);
+  for (auto &helper : helpers) {
+    helper->playMove(cell, piece);
   }
-
-  MovesList moveHistory = {};
-  int bestScore = MINWIN;
-
-  for (int i = 0; i < moves.size(); i++) {
-    Coord move = moves[i];
-    gameState[move.first][move.second] = PLAYER_PIECE;
-    MovesList newMoves = {};
-    if (gravityOn and colHasSpace(move.first)) {
-      newMoves.push_back(dropPiece(move.first));
-    }
-    for (int j = 0; j < i; j++) {
-      newMoves.push_back(moves[j]);
-    }
-    for (int j = i + 1; j < moves.size(); j++) {
-      newMoves.push_back(moves[j]);
-    }
-    MovesList childMoveHistory;
-    int stateScore;
-    tie(childMoveHistory, stateScore) = minPlayer(newMoves, depth - 1, a, b);
-    gameState[move.first][move.second] = NO_PIECE;
-    if (stateScore > bestScore) {
-      bestScore = stateScore;
-      moveHistory.clear();
-      moveHistory.push_back(move);
-      // if (!childMoveHistory.empty()) {
-      for (auto item : childMoveHistory) {
-        moveHistory.push_back(item);
-      }
-      // }
-    }
-    a = max(bestScore, a);
-
-    checkTime();
-
-    if (a >= b or outOfTime) {
-      break;
-    }
+  if (pool) {
+    pool->playMove(cell, piece);
   }
-
-  return {moveHistory, bestScore};
 }
 
-const pair<Coord, int> AIShell::startMiniMax(const int depth) {
-  MovesList moveHistory;
-  uniform_int_distribution<int> uni(0, moves.size() - 1);
-  Coord bestMove = moves[uni(rng)];
-  int a = MINWIN;         // lost = true
-  int b = MAXWIN;         // won = true
-  int bestScore = MINWIN; // lost = true
-
-  vector<vector<int>> scoreBoard;
-  if (DEBUG) {
-    scoreBoard.resize(numCols, vector<int>(numRows, 0));
+// Searches the searchers' root until control says to stop. The caller sets
+// up control, so that a stop request cannot be missed by a search that has
+// yet to start.
+const Move AIShell::runIDS() {
+  tt.newSearch();
+  const Clock::time_point searchStart = Clock::now();
+  const long long poolNodes = pool ? pool->nodes() : 0;
+
+  // The main thread's result is the one returned; helpers start from the
+  // move chain it expects.
+  vector<thread> helperThreads;
+  for (auto &helper : helpers) {
+    Searcher *searcher = helper.get();
+    searcher->lastMoves = mainSearcher->lastMoves;
+    helperThreads.emplace_back([searcher] { searcher->runIDS(); });
   }
 
-  for (int i = 0; i < moves.size(); i++) {
-    Coord move = moves[i];
-    MovesList newMoves = {};
-    gameState[move.first][move.second] = PLAYER_PIECE;
-    if (gravityOn and colHasSpace(move.first)) {
-      newMoves.push_back(dropPiece(move.first));
-    }
-    for (int j = 0; j < i; j++) {
-      newMoves.push_back(moves[j]);
-    }
-    for (int j = i + 1; j < moves.size(); j++) {
-      newMoves.push_back(moves[j]);
-    }
-    MovesList childMoveHistory;
-    int stateScore;
-    tie(childMoveHistory, stateScore) = minPlayer(newMoves, depth - 1, a, b);
-    gameState[move.first][move.second] = NO_PIECE;
-    if (stateScore > bestScore) {
-      bestScore = stateScore;
-      moveHistory = childMoveHistory;
-      bestMove = move;
-    }
-    a = max(bestScore, a);
-
-    if (DEBUG) {
-      scoreBoard[move.first][move.second] = stateScore;
-    }
-
-    checkTime();
-
-    if (a >= b or outOfTime) {
-      break;
-    }
+  Coord bestMove;
+  int bestScore;
+  tie(bestMove, bestScore) = mainSearcher->runIDS();
+  // What the search left of the budget by not starting iterations it could
+  // not finish (or by finishing the game).
+  const Clock::duration timeSaved =
+      control.outOfTime ? Clock::duration::zero() : control.time.remaining();
+
+  control.outOfTime = true; // stop the helpers
+  for (auto &helperThread : helperThreads) {
+    helperThread.join();
   }
 
-  if (!outOfTime) {
-    lastMoves.clear();
-    lastMoves.push_back(bestMove);
-    if (!moveHistory.empty()) {
-      for (auto item : moveHistory) {
-        lastMoves.push_back(item);
-      }
-    }
+  long long nodes = mainSearcher->nodes;
+  for (auto &helper : helpers) {
+    nodes += helper->nodes;
+  }
+  if (pool) {
+    nodes += pool->nodes() - poolNodes;
   }
+  report.score = bestScore;
+  report.depth = mainSearcher->depthReached;
+  report.nodes = nodes;
+  report.timeSavedMs = duration_cast<milliseconds>(timeSaved).count();
+  report.timeWastedMs =
+      duration_cast<milliseconds>(mainSearcher->timeWasted).count();
+  report.source = "search";
 
-  if (DEBUG and !outOfTime) {
-    // Print score board
-    for (int y = numRows - 1; y >= 0; y--) {
-      cout << "[\t";
-      for (int x = 0; x < numCols; x++) {
-        if (gameState[x][y] == PLAYER_PIECE) {
-          cout << "[P]\t";
-        } else if (gameState[x][y] == OPPONENT_PIECE) {
-          cout << "[E]\t";
-        } else if (x == bestMove.first and y == bestMove.second) {
-          cout << "(";
-          if (scoreBoard[x][y] == MAXWIN) {
-            cout << "W!";
-          } else if (scoreBoard[x][y] == MINWIN) {
-            cout << "L!";
-          } else {
-            cout << scoreBoard[x][y];
-          }
-          cout << ")\t";
-        } else {
-          if (scoreBoard[x][y] == MAXWIN) {
-            cout << "W!\t";
-          } else if (scoreBoard[x][y] == MINWIN) {
-            cout << "L!\t";
-          } else if (!notInMoves({x, y})) {
-            cout << scoreBoard[x][y] << "\t";
-          } else {
-            cout << "-\t";
-          }
-        }
-      }
-      cout << "]" << endl;
-    }
-    // Print expected path
-    cout << "Expected path: ";
-    for (int i = 0; i < lastMoves.size(); i++) {
-      if (i != 0) {
-        cout << "->";
-      }
-      cout << "(" << lastMoves[i].first << ", " << lastMoves[i].second << ")";
-    }
-    cout << endl << endl;
+  if (DEBUG) {
+    const long long elapsed =
+        max<long long>(
+            duration_cast<milliseconds>(Clock::now() - searchStart).count(),
+            1);
+    cout << "Depth " << mainSearcher->depthReached << ", " << nodes
+         << " nodes on " << options.threads << " threads ("
+         << nodes * 1000 / elapsed << " nodes/s)." << endl;
+    cout << report.timeSavedMs << "ms of the budget saved, "
+         << report.timeWastedMs << "ms spent on an unfinished iteration."
+         << endl;
   }
 
-  return {bestMove, bestScore};
+  return {bestMove.first, bestMove.second};
 }
 
-const Move AIShell::runIDS() {
-  findMoves();
-  lastMoves.clear();
-  int bestScore = MINWIN;
-  Move bestMove = {moves[0].first, moves[0].second};
-
-  for (int depth = 1; !outOfTime and bestScore < MAXWIN and
-                      (gravityOn or depth <= moves.size());
-       depth++) {
-    if (DEBUG) {
-      cout << "Searching with depth " << depth << "..." << endl;
-    }
-    // Start using last move data from previous depth when length >= 3.
-    if (lastMoves.size() >= 3) {
-      if (DEBUG) {
-        cout << "Prioritizing last depth's expected path." << endl;
-      }
-      findMoves();
-    }
-    Coord currentMove;
-    int currentScore;
-    tie(currentMove, currentScore) = startMiniMax(depth);
-    if (!outOfTime and (currentScore > MINWIN or bestScore == MINWIN)) {
-      bestMove = {currentMove.first, currentMove.second};
-      bestScore = currentScore;
-    }
-    if (DEBUG and !outOfTime and (!gravityOn and depth == moves.size())) {
-      cout << "Search space exhausted." << endl;
-    } else if (DEBUG and bestScore == MAXWIN) {
-      cout << "Winning move found." << endl;
-    }
-  }
-  if (DEBUG and outOfTime) {
-    cout << "Time limit reached." << endl << endl;
+// Searches the game position with MCTS until control says to stop.
+const Move AIShell::runMcts() {
+  const int cell = mcts->search();
+  report.score = 0;
+  report.depth = 0;
+  report.nodes = mcts->playouts;
+  report.source = "mcts";
+  if (DEBUG) {
+    cout << mcts->playouts << " playouts on " << options.threads
+         << " threads, " << mcts->rootVisits() << " visits at the root, "
+         << mcts->treeSize() << " nodes in the tree." << endl;
   }
-
-  return bestMove;
+  return {board->colOf(cell), board->rowOf(cell)};
 }
 
 Move AIShell::makeMove() {
-  this->startTime = currentTime();
-  this->stopTime = startTime + milliseconds(this->deadline) - TIME_MARGIN;
+  // On a ponder hit this also hands the running search our deadline. Time
+  // spent in setState, clearing the table for a new game, counts too.
+  control.time.start(milliseconds(this->deadline),
+                     milliseconds(options.timeMarginMs), requestTime);
   Move m;
 
-  if (DEBUG) {
+  if (DEBUG and !ponderHit) {
+    const MovesList &lastMoves = mainSearcher->lastMoves;
     cout << "Expected move chain from last turn: ";
     for (int i = 0; i < lastMoves.size(); i++) {
       if (i != 0) {
@@ -573,26 +250,152 @@ Move AIShell::makeMove() {
     cout << endl << endl;
   }
 
-  // Return center position if we're making the opening move.
-  if (lastMove == Move(-1, -1)) {
+  if (ponderHit) {
+    // The search started on the opponent's time now has to finish by our
+    // deadline.
+    ponderThread.join();
+    m = ponderMove;
+    ponderHit = false;
+  } else if (lastMove == Move(-1, -1)) {
+    // Return center position if we're making the opening move.
+    report = Report();
     if (gravityOn) {
       m = Move(numCols / 2, 0);
     } else {
       m = Move(numCols / 2, numRows / 2);
     }
-  } else {
-    m = runIDS();
+  } else if (!solve(m)) {
+    control.outOfTime = false;
+    m = mcts ? runMcts() : runIDS();
   }
 
+  report.move = m;
+  play(board->cell(m.col, m.row), PLAYER_PIECE);
+
   if (DEBUG) {
-    cout << (currentTime() - startTime).count() << "ms elapsed." << endl;
+    cout << control.time.elapsed().count() << "ms elapsed." << endl;
     cout << "Returning " << m << "." << endl;
   }
 
-  // Waits to return the move until time is up.
-  while (!outOfTime) {
-    checkTime();
+  // The tree search keeps its own tree across moves instead.
+  if (options.ponder and !mcts) {
+    startPondering(m);
   }
 
   return m;
 }
+
+Move AIShell::analyse(bool gravityOn, int numCols, int numRows, int k,
+                      const vector<int> &cells, int deadline) {
+  requestTime = Clock::now();
+  // An entry is keyed by the position, so it still holds for another
+  // position under the same rules; the next search's generation lets it be
+  // replaced first. Under other rules the same key can mean another board.
+  const bool sameRules = board and gravityOn == this->gravityOn and
+                         numCols == this->numCols and
+                         numRows == this->numRows and k == this->k;
+  stopPondering();
+  this->gravityOn = gravityOn;
+  this->numCols = numCols;
+  this->numRows = numRows;
+  this->k = k;
+  this->lastMove = Move(-1, -1);
+  this->deadline = deadline;
+  ponderCell = -1;
+  ponderHit = false;
+  newGame(cells, !sameRules);
+
+  control.time.start(milliseconds(deadline),
+                     milliseconds(options.timeMarginMs), requestTime);
+  report = Report();
+  Move m;
+  if (!solve(m)) {
+    control.outOfTime = false;
+    m = mcts ? runMcts() : runIDS();
+  }
+  report.move = m;
+  return m;
+}
+
+// Positions with few empty cells left are handed to the proof-number solver
+// first. A solved position is answered at once; otherwise the search gets
+// the rest of the time.
+bool AIShell::solve(Move &m) {
+  const int emptyCells = board->numCells() - board->numPieces();
+  if (emptyCells > options.solveCells) {
+    return false;
+  }
+  if (!solver) {
+    solver.reset(new ProofSearch(*board, options.solveHashMb));
+  }
+  int cell;
+  const ProofSearch::Result result = solver->solve(
+      *board, Clock::now() + control.time.remaining() / SOLVE_SHARE, cell);
+  if (DEBUG) {
+    const char *names[] = {"unknown", "win", "loss", "draw"};
+    cout << "Solver: " << names[result] << " after " << solver->nodes
+         << " nodes." << endl;
+  }
+  if (result == ProofSearch::UNKNOWN) {
+    return false;
+  }
+  m = Move(board->colOf(cell), board->rowOf(cell));
+  report.score = (result == ProofSearch::WIN)    ? Searcher::MAXWIN
+                 : (result == ProofSearch::LOSS) ? Searcher::MINWIN
+                                                 : 0;
+  report.depth = emptyCells;
+  report.nodes = solver->nodes;
+  report.source = "solver";
+  return true;
+}
+
+// Plays the opponent reply the search expects after move, the second step of
+// its move chain, on the searchers and searches on from there in the
+// background.
+void AIShell::startPondering(const Move move) {
+  const MovesList &expected = mainSearcher->lastMoves;
+  if (expected.size() < 2 or expected[0] != Coord(move.col, move.row) or
+      board->hasWin(PLAYER_PIECE) or
+      board->numPieces() + 1 >= board->numCells()) {
+    return;
+  }
+  const Coord reply = expected[1];
+  if (!board->isEmpty(reply.first, reply.second) or
+      (gravityOn and board->height(reply.first) != reply.second)) {
+    return;
+  }
+  const int replyCell = board->cell(reply.first, reply.second);
+  board->place(replyCell, OPPONENT_PIECE);
+  const bool gameOver = board->hasWin(OPPONENT_PIECE);
+  board->remove(replyCell, OPPONENT_PIECE);
+  if (gameOver) {
+    return;
+  }
+
+  ponderCell = replyCell;
+  playOnSearchers(ponderCell, OPPONENT_PIECE);
+  if (DEBUG) {
+    cout << "Pondering on (" << reply.first << ", " << reply.second << ")."
+         << endl;
+  }
+  control.time.startUnlimited();
+  control.outOfTime = false;
+  ponderThread = thread([this] { ponderMove = runIDS(); });
+}
+
+void AIShell::stopPondering() {
+  if (ponderThread.joinable()) {
+    control.outOfTime = true;
+    ponderThread.join();
+  }
+}
+
+void AIShell::takeBackOnSearchers(const int cell, const int piece) {
+  mainSearcher->takeBackMove(cell, piece);
+  for (auto &helper : helpers) {
+    helper->takeBackMove(cell, piece);
+  }
+  if (pool) {
+    pool->takeBackMove(cell, piece);
+  }
+}
@@ -1,16 +1,24 @@
 #ifndef AISHELL_H
 #define AISHELL_H
 
+#include "Board.h"
+#include "MonteCarlo.h"
 #include "Move.h"
+#include "ProofSearch.h"
+#include "SearchOptions.h"
+#include "Searcher.h"
+#include "TranspositionTable.h"
 #include <chrono>
+#include <memory>
+#include <thread>
 #include <vector>
 
-namespace {
-typedef std::pair<int, int> Coord;
-typedef std::vector<Coord> MovesList;
-}
+class ThreadPool;
 
-// A new AIShell will be created for every move request.
+// One AIShell answers every move request of a session. Between the moves of
+// a game it keeps its board, transposition table and searchers (with their
+// buffers and the expected move chain) warm; a request that does not continue
+// the game it was playing starts a new one.
 class AIShell {
   public:
     // these represent the values for each piece type.
@@ -18,50 +26,83 @@ class AIShell {
     static const int OPPONENT_PIECE = -1;
     static const int NO_PIECE = 0;
 
+    // How the last move was found.
+    struct Report {
+        Move move;
+        // For the side to move, from Searcher::MINWIN to Searcher::MAXWIN;
+        // 0 when the engine gives no score.
+        int score = 0;
+        int depth = 0; // deepest iteration completed, or plies solved
+        long long nodes = 0; // positions searched, or MCTS playouts
+        // Of the search's budget: left unused because the next iteration
+        // would not have finished (or the game was decided), and spent on
+        // an iteration the deadline cut short.
+        long long timeSavedMs = 0;
+        long long timeWastedMs = 0;
+        const char *source = "opening"; // "search", "solver" or "mcts"
+    };
+
   private:
-    // Do not alter the values of numRows or numcols.
-    // they are used for deallocating the gameState variable.
-    const bool gravityOn; // this will be true if gravity is turned on. It will
-                          // be false if gravity is turned off.
-    const int numCols;    // the total number of columns in the game state.
-    const int numRows;    // the total number of rows in the game state.
-    const int k;
-    int **gameState;     // a pointer to a two-dimensional array representing
-                         // the game state.
-    const Move lastMove; // this is the move made last by your opponent. If your
-                         // opponent has not made a move yet (you move first)
-                         // then this move will hold the value (-1, -1) instead.
-    const int deadline;
-    MovesList moves;
-    std::chrono::milliseconds startTime;
-    std::chrono::milliseconds stopTime;
-    bool outOfTime = false;
+    bool gravityOn = false; // this will be true if gravity is turned on. It
+                            // will be false if gravity is turned off.
+    int numCols = 0;        // the total number of columns in the game state.
+    int numRows = 0;        // the total number of rows in the game state.
+    int k = 0;
+    Move lastMove; // this is the move made last by your opponent. If your
+                   // opponent has not made a move yet (you move first)
+                   // then this move will hold the value (-1, -1) instead.
+    int deadline = 0;
+    // When the position to move in arrived, which the deadline counts from.
+    Clock::time_point requestTime;
+    const SearchOptions options;
+    std::unique_ptr<Board> board; // the game being played, once there is one
+    TranspositionTable tt;        // shared by all search threads
+    SearchControl control;
+    std::unique_ptr<ThreadPool> pool; // YBW workers
+    std::unique_ptr<Searcher> mainSearcher;
+    std::vector<std::unique_ptr<Searcher>> helpers; // Lazy SMP threads
+    std::unique_ptr<ProofSearch> solver; // for positions nearly filled up
+    std::unique_ptr<MonteCarlo> mcts;    // in place of the searchers
+    // Pondering: the searchers' root is the game position plus ponderCell,
+    // the opponent reply the last search expected, searched by ponderThread
+    // until the next request arrives. If the opponent did play it, that
+    // search carries on as the search for our move and ends with ponderMove.
+    int ponderCell = -1;
+    bool ponderHit = false;
+    std::thread ponderThread;
+    Move ponderMove;
+    Report report;
 
-    bool timeLeft() const;
-    void checkTime();
-    const Coord dropPiece(const int col) const;
-    bool colHasSpace(const int col) const;
-    bool notInMoves(const Coord move) const;
-    bool colNotEmpty(const int col) const;
-    void findMoves();
-    int staticEval() const;
+    bool continuesGame(const std::vector<int> &cells) const;
+    void newGame(const std::vector<int> &cells, bool clearTable = true);
+    void play(const int cell, const int piece);
+    void playOnSearchers(const int cell, const int piece);
+    void takeBackOnSearchers(const int cell, const int piece);
+    void startPondering(const Move move);
+    bool solve(Move &m);
     const Move runIDS();
-    const std::pair<Coord, int> startMiniMax(const int depth);
-    const std::pair<MovesList, int> minPlayer(const MovesList moves,
-                                              const int depth, int a, int b);
-    const std::pair<MovesList, int> maxPlayer(const MovesList moves,
-                                              const int depth, int a, int b);
+    const Move runMcts();
 
   public:
-    // int deadline; // this is how many milliseconds the AI has to make move.
-    // int k;        // k is the number of pieces a player must get in a
-    // row/column/diagonal to win the game. IE in connect 4, this
-    // variable would be 4
-
-    AIShell(bool gravityOn, int numCols, int numRows, int k, int **gameState,
-            Move lastMove, int deadline);
+    explicit AIShell(const SearchOptions &options = SearchOptions());
     ~AIShell();
+    // Takes the position of a new move request. cells holds the piece in
+    // every cell, column by column, as sent by the Java shell. deadline is
+    // how many milliseconds the AI has to make its move, and k is the number
+    // of pieces a player must get in a row/column/diagonal to win the game.
+    // The board must fit a Board (see Board::fits).
+    void setState(bool gravityOn, int numCols, int numRows, int k,
+                  const std::vector<int> &cells, Move lastMove, int deadline);
     Move makeMove();
+    // Searches a position on its own, as the first move of a new game,
+    // without playing the move found. The engine is PLAYER_PIECE whatever
+    // the count of pieces, and there is always a search, even on an empty
+    // board. The position must have an empty cell and no line yet.
+    Move analyse(bool gravityOn, int numCols, int numRows, int k,
+                 const std::vector<int> &cells, int deadline);
+    const Report &lastReport() const { return report; }
+    // Stops the background search, if any, before the next request.
+    void stopPondering();
 };
 
 #endif // AISHELL_H
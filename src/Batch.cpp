@@ -0,0 +1,164 @@
+#include "Batch.h"
+#include "Board.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+// Deadline of a search limited by depth only.
+static const int NO_TIME_LIMIT = INT_MAX;
+
+// Why position cannot be searched, or an empty string if it can.
+string checkPosition(const BatchPosition &position) {
+    if (!Board::fits(position.numCols, position.numRows)) {
+        return "unsupported board size";
+    }
+    if (position.k < 1 or
+        position.k > max(position.numCols, position.numRows)) {
+        return "k does not fit the board";
+    }
+    if (position.depth < 0 or position.timeMs < 0 or
+        (position.depth == 0 and position.timeMs == 0)) {
+        return "needs a depth or time limit";
+    }
+    Board board(position.gravityOn, position.numCols, position.numRows,
+                position.k);
+    for (int cell = 0; cell < board.numCells(); cell++) {
+        const int piece = position.cells[cell];
+        if (piece != AIShell::PLAYER_PIECE and
+            piece != AIShell::OPPONENT_PIECE and piece != AIShell::NO_PIECE) {
+            return "cells must be 1, -1 or 0";
+        }
+        if (piece == AIShell::NO_PIECE) {
+            continue;
+        }
+        if (position.gravityOn and
+            board.height(board.colOf(cell)) != board.rowOf(cell)) {
+            return "piece above an empty cell";
+        }
+        board.place(cell, piece);
+    }
+    if (board.numPieces() == board.numCells()) {
+        return "board is full";
+    }
+    if (board.hasWin(AIShell::PLAYER_PIECE) or
+        board.hasWin(AIShell::OPPONENT_PIECE)) {
+        return "game is already won";
+    }
+    return "";
+}
+} // namespace
+
+bool readBatch(istream &in, vector<BatchPosition> &positions, string &error) {
+    string line;
+    for (int lineNumber = 1; getline(in, line); lineNumber++) {
+        const size_t start = line.find_first_not_of(" \t\r");
+        if (start == string::npos or line[start] == '#') {
+            continue;
+        }
+        istringstream fields(line);
+        BatchPosition position;
+        int gravity;
+        if (!(fields >> gravity >> position.numCols >> position.numRows >>
+              position.k >> position.depth >> position.timeMs)) {
+            error = "line " + to_string(lineNumber) + ": bad header";
+            return false;
+        }
+        position.gravityOn = gravity != 0;
+        int piece;
+        while (fields >> piece) {
+            position.cells.push_back(piece);
+        }
+        string problem;
+        if (!fields.eof()) {
+            problem = "cells must be numbers";
+        } else if (int(position.cells.size()) !=
+                   position.numCols * position.numRows) {
+            problem = "expected " +
+                      to_string(position.numCols * position.numRows) +
+                      " cells, got " + to_string(position.cells.size());
+        } else {
+            problem = checkPosition(position);
+        }
+        if (!problem.empty()) {
+            error = "line " + to_string(lineNumber) + ": " + problem;
+            return false;
+        }
+        positions.push_back(position);
+    }
+    return true;
+}
+
+vector<BatchResult> runBatch(const vector<BatchPosition> &positions,
+                             const SearchOptions &options, int workers,
+                             ostream *out) {
+    const int count = positions.size();
+    vector<BatchResult> results(count);
+    vector<bool> done(count, false);
+    atomic<int> next{0};
+    mutex lock; // guards results, done and written
+    int written = 0;
+
+    // A worker keeps its AIShell, and with it the table and searchers, from
+    // one position to the next; only a new depth limit needs a new one.
+    auto work = [&] {
+        unique_ptr<AIShell> shell;
+        int shellDepth = -1;
+        for (int i = next++; i < count; i = next++) {
+            const BatchPosition &position = positions[i];
+            if (!shell or position.depth != shellDepth) {
+                SearchOptions own = options;
+                own.maxDepth = position.depth;
+                own.ponder = false;
+                shell.reset(new AIShell(own));
+                shellDepth = position.depth;
+            }
+            const Clock::time_point start = Clock::now();
+            shell->analyse(position.gravityOn, position.numCols,
+                           position.numRows, position.k, position.cells,
+                           position.timeMs > 0 ? position.timeMs
+                                               : NO_TIME_LIMIT);
+            BatchResult result;
+            result.report = shell->lastReport();
+            if (position.timeMs == 0) {
+                // Without a deadline there is no budget to save.
+                result.report.timeSavedMs = 0;
+            }
+            result.timeMs =
+                duration_cast<milliseconds>(Clock::now() - start).count();
+
+            lock_guard<mutex> guard(lock);
+            results[i] = result;
+            done[i] = true;
+            for (; out and written < count and done[written]; written++) {
+                writeBatchResult(*out, written, results[written]);
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (int w = 1; w < min(workers, count); w++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &worker : threads) {
+        worker.join();
+    }
+    return results;
+}
+
+void writeBatchResult(ostream &out, int index, const BatchResult &result) {
+    const AIShell::Report &report = result.report;
+    out << index << '\t' << report.move.col << '\t' << report.move.row << '\t'
+        << report.score << '\t' << report.depth << '\t' << report.nodes
+        << '\t' << result.timeMs << '\t' << report.timeSavedMs << '\t'
+        << report.timeWastedMs << '\t' << report.source << endl;
+}
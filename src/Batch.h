@@ -0,0 +1,61 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "AIShell.h"
+#include "SearchOptions.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Offline analysis of many positions, for tuning and regression runs.
+//
+// Each line of the input is a position, blank lines and lines starting with
+// '#' aside:
+//
+//     gravity cols rows k depth ms cells...
+//
+// gravity is 0 or 1. depth and ms limit the search, 0 meaning no limit, but
+// one of them has to be set. Then come the cols * rows cells, column by
+// column from the bottom as in the shell's requests: 1 for the side to move,
+// -1 for the other side and 0 for an empty cell.
+//
+// The positions are shared out between worker threads, each with its own
+// AIShell, so that positions per second scale with the cores when each
+// search runs on one thread. One line is written per position, in the order
+// they were read, with tab-separated fields:
+//
+//     index col row score depth nodes ms saved wasted source
+//
+// where saved and wasted are the milliseconds of the search's budget left
+// unused and spent on an unfinished iteration, and source says which engine
+// found the move (see AIShell::Report).
+struct BatchPosition {
+    bool gravityOn = false;
+    int numCols = 0;
+    int numRows = 0;
+    int k = 0;
+    int depth = 0;
+    int timeMs = 0;
+    std::vector<int> cells;
+};
+
+struct BatchResult {
+    AIShell::Report report;
+    long long timeMs = 0;
+};
+
+// Reads every position of in. On a malformed or finished position returns
+// false with error saying which line and why.
+bool readBatch(std::istream &in, std::vector<BatchPosition> &positions,
+               std::string &error);
+
+// Analyses positions on workers threads with options, except for their own
+// depth limits, and returns their results in order. Each result is written
+// to out, if given, as soon as those before it are.
+std::vector<BatchResult> runBatch(const std::vector<BatchPosition> &positions,
+                                  const SearchOptions &options, int workers,
+                                  std::ostream *out = nullptr);
+
+void writeBatchResult(std::ostream &out, int index, const BatchResult &result);
+
+#endif // BATCH_H
@@ -0,0 +1,145 @@
+#include "Board.h"
+#include <algorithm>
+
+namespace {
+// Sets out to in >> amount, treating the first n words of in as one integer.
+inline void shiftRight(const uint64_t *in, uint64_t *out, int n, int amount) {
+    const int wordShift = amount >> 6;
+    const int bitShift = amount & 63;
+    for (int i = 0; i < n; i++) {
+        const int src = i + wordShift;
+        uint64_t value = (src < n) ? (in[src] >> bitShift) : 0;
+        if (bitShift != 0 and src + 1 < n) {
+            value |= in[src + 1] << (64 - bitShift);
+        }
+        out[i] = value;
+    }
+}
+
+// Fills the Zobrist keys from a fixed-seed splitmix64 sequence so that hashes
+// are reproducible between runs.
+struct ZobristInitializer {
+    ZobristInitializer() {
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (int side = 0; side < 2; side++) {
+            for (int cell = 0; cell < Board::MAX_CELLS; cell++) {
+                uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                Board::zobrist[side][cell] = z ^ (z >> 31);
+            }
+        }
+    }
+};
+} // namespace
+
+uint64_t Board::zobrist[2][MAX_CELLS];
+static ZobristInitializer zobristInitializer;
+
+Board::Board(bool gravityOn, int numCols, int numRows, int k)
+    : gravity{gravityOn}, cols{numCols}, rows{numRows}, winLength{k},
+      cells{numCols * numRows}, words{(numCols * numRows + 63) / 64} {
+    shift[0] = 1;            // vertical
+    shift[1] = rows;         // horizontal
+    shift[2] = rows + 1;     // up-right diagonal
+    shift[3] = rows - 1;     // down-right diagonal
+    const int colStep[NUM_DIRECTIONS] = {0, 1, 1, 1};
+    const int rowStep[NUM_DIRECTIONS] = {1, 0, 1, -1};
+
+    std::fill(&lineStarts[0][0], &lineStarts[0][0] + NUM_DIRECTIONS * MAX_WORDS,
+              uint64_t(0));
+    std::fill(&bits[0][0], &bits[0][0] + 2 * MAX_WORDS, uint64_t(0));
+    std::fill(heights, heights + MAX_COLS, 0);
+    std::fill(hashKeys, hashKeys + MAX_SYMMETRIES, uint64_t(0));
+
+    if (gravity) {
+        symmetries = 2;
+    } else if (cols != rows) {
+        symmetries = 4;
+    } else {
+        symmetries = 8;
+    }
+
+    for (int dir = 0; dir < NUM_DIRECTIONS; dir++) {
+        for (int col = 0; col < cols; col++) {
+            for (int row = 0; row < rows; row++) {
+                const int endCol = col + (k - 1) * colStep[dir];
+                const int endRow = row + (k - 1) * rowStep[dir];
+                if (endCol < cols and endRow >= 0 and endRow < rows) {
+                    const int start = cell(col, row);
+                    lineStarts[dir][start >> 6] |= uint64_t(1) << (start & 63);
+                }
+            }
+        }
+    }
+}
+
+// Doubles the run length found at each cell until it covers k cells: after
+// each step bit p of run is set iff p and the following len - 1 cells along
+// the direction are all set in mask.
+bool Board::hasLine(const uint64_t *mask, int dir) const {
+    uint64_t run[MAX_WORDS];
+    uint64_t shifted[MAX_WORDS];
+    std::copy(mask, mask + words, run);
+
+    int len = 1;
+    while (len < winLength) {
+        const int step = std::min(len, winLength - len);
+        shiftRight(run, shifted, words, step * shift[dir]);
+        for (int i = 0; i < words; i++) {
+            run[i] &= shifted[i];
+        }
+        len += step;
+    }
+
+    for (int i = 0; i < words; i++) {
+        if (run[i] & lineStarts[dir][i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Board::hasWin(int piece) const {
+    const uint64_t *mask = bits[side(piece)];
+    for (int dir = 0; dir < NUM_DIRECTIONS; dir++) {
+        if (hasLine(mask, dir)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The same doubling as hasLine, run on the side's pieces with AND and on the
+// other side's with OR, so that every window start ends up with whether the
+// window is full and whether it is touched. Each word settles 64 windows at
+// once, and the loops over words are left simple enough for the compiler to
+// vectorize on larger boards.
+void Board::countWindows(int piece, int &wins, int &possibleWins) const {
+    uint64_t full[MAX_WORDS];
+    uint64_t touched[MAX_WORDS];
+    uint64_t shifted[MAX_WORDS];
+    wins = possibleWins = 0;
+    for (int dir = 0; dir < NUM_DIRECTIONS; dir++) {
+        std::copy(bits[side(piece)], bits[side(piece)] + words, full);
+        std::copy(bits[side(-piece)], bits[side(-piece)] + words, touched);
+        int len = 1;
+        while (len < winLength) {
+            const int step = std::min(len, winLength - len);
+            shiftRight(full, shifted, words, step * shift[dir]);
+            for (int i = 0; i < words; i++) {
+                full[i] &= shifted[i];
+            }
+            shiftRight(touched, shifted, words, step * shift[dir]);
+            for (int i = 0; i < words; i++) {
+                touched[i] |= shifted[i];
+            }
+            len += step;
+        }
+        for (int i = 0; i < words; i++) {
+            wins += __builtin_popcountll(full[i] & lineStarts[dir][i]);
+            possibleWins +=
+                __builtin_popcountll(~touched[i] & lineStarts[dir][i]);
+        }
+    }
+}
@@ -0,0 +1,242 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <cstdint>
+
+// Bitboard representation of a ConnectK game state.
+//
+// Each side owns one bitmask with one bit per cell, laid out column by column
+// (cell = col * numRows + row), so a 9x7 board fits in a single 64-bit word per
+// side. Larger boards spill over into further words, up to MAX_CELLS cells.
+// Gravity boards additionally track the height of every column so that the
+// next free row can be looked up instead of scanned for.
+class Board {
+  public:
+    static const int MAX_WORDS = 16;
+    static const int MAX_CELLS = MAX_WORDS * 64;
+    static const int MAX_COLS = 64;
+    static const int NUM_DIRECTIONS = 4;
+    // Symmetries of the board, numbered so that the ones valid for a board
+    // come first: identity and left-right mirror (all boards), top-bottom
+    // mirror and half turn (no gravity), and the four that swap rows and
+    // columns (square boards without gravity).
+    static const int MAX_SYMMETRIES = 8;
+
+  private:
+    bool gravity;
+    int cols;
+    int rows;
+    int winLength;
+    int cells;
+    int words;
+    int pieces = 0;
+    int symmetries;
+    // Zobrist hash of the position as seen through each symmetry.
+    uint64_t hashKeys[MAX_SYMMETRIES];
+    // Distance between neighbouring cells of a line in each direction:
+    // vertical, horizontal, up-right diagonal and down-right diagonal.
+    int shift[NUM_DIRECTIONS];
+    // Cells from which a whole line of k cells in each direction fits on the
+    // board. Masking with these keeps the shift-and-AND win tests from
+    // wrapping around the edges of the board.
+    uint64_t lineStarts[NUM_DIRECTIONS][MAX_WORDS];
+    uint64_t bits[2][MAX_WORDS];
+    int heights[MAX_COLS];
+
+    // Index into bits for a piece value: AIShell::PLAYER_PIECE (1) is side 0
+    // and AIShell::OPPONENT_PIECE (-1) is side 1.
+    static int side(int piece) { return piece > 0 ? 0 : 1; }
+    // Where a cell of a board of numCols by numRows ends up under a symmetry.
+    static int transform(int cell, int symmetry, int numCols, int numRows);
+    bool hasLine(const uint64_t *mask, int dir) const;
+    // The work of place and remove, given the board's dimensions and
+    // symmetries, which the shape kernels pass as constants.
+    void updateHashes(int cell, int piece, int numCols, int numRows,
+                      int numSymmetries);
+    void placeSized(int cell, int piece, int numCols, int numRows,
+                    int numSymmetries);
+    void removeSized(int cell, int piece, int numCols, int numRows,
+                     int numSymmetries);
+
+  public:
+    // Random keys per side and cell. The hash of a position is the XOR of
+    // the keys of its pieces, kept up to date by place and remove.
+    static uint64_t zobrist[2][MAX_CELLS];
+
+    // Whether a board of numCols by numRows fits the fixed-size arrays. No
+    // Board may be made larger.
+    static bool fits(int numCols, int numRows) {
+        return numCols >= 1 and numRows >= 1 and numCols <= MAX_COLS and
+               numRows <= MAX_CELLS / numCols;
+    }
+
+    Board(bool gravityOn, int numCols, int numRows, int k);
+
+    bool gravityOn() const { return gravity; }
+    int numCols() const { return cols; }
+    int numRows() const { return rows; }
+    int k() const { return winLength; }
+    int numCells() const { return cells; }
+    int numWords() const { return words; }
+    int numPieces() const { return pieces; }
+    uint64_t hash() const { return hashKeys[0]; }
+
+    int numSymmetries() const { return symmetries; }
+    // The smallest hash over all valid symmetries, which is the same for
+    // every mirrored or rotated copy of a position. symmetry is set to the
+    // symmetry that maps this position onto the canonical one.
+    uint64_t canonicalHash(int &symmetry) const;
+    // Where a cell ends up under a symmetry, and back.
+    int transformCell(int cell, int symmetry) const;
+    int inverseTransformCell(int cell, int symmetry) const;
+
+    int cell(int col, int row) const { return col * rows + row; }
+    int colOf(int cell) const { return cell / rows; }
+    int rowOf(int cell) const { return cell % rows; }
+
+    int pieceAt(int cell) const;
+    int pieceAt(int col, int row) const { return pieceAt(cell(col, row)); }
+    bool isEmpty(int cell) const;
+    bool isEmpty(int col, int row) const { return isEmpty(cell(col, row)); }
+
+    // Number of pieces in a gravity column, i.e. the row a dropped piece
+    // lands in.
+    int height(int col) const { return heights[col]; }
+    bool colHasSpace(int col) const;
+    bool colNotEmpty(int col) const;
+
+    void place(int cell, int piece);
+    void remove(int cell, int piece);
+    // Whether the board is of Shape (see BoardShape), and place and remove
+    // for a board that is, with its dimensions known to the compiler.
+    template <class Shape> bool isShape() const {
+        return gravity == Shape::gravityOn() and cols == Shape::numCols() and
+               rows == Shape::numRows() and winLength == Shape::k();
+    }
+    template <class Shape> void placeShape(int cell, int piece) {
+        placeSized(cell, piece, Shape::numCols(), Shape::numRows(),
+                   Shape::numSymmetries());
+    }
+    template <class Shape> void removeShape(int cell, int piece) {
+        removeSized(cell, piece, Shape::numCols(), Shape::numRows(),
+                    Shape::numSymmetries());
+    }
+
+    // Whether the given side has k in a row anywhere on the board.
+    bool hasWin(int piece) const;
+    // Counts the windows of k cells, in all four directions, that the side
+    // of piece fills (wins) and that hold no piece of the other side
+    // (possibleWins): the totals Evaluator keeps, from scratch.
+    void countWindows(int piece, int &wins, int &possibleWins) const;
+
+    const uint64_t *mask(int piece) const { return bits[side(piece)]; }
+};
+
+inline int Board::pieceAt(int cell) const {
+    const uint64_t bit = uint64_t(1) << (cell & 63);
+    if (bits[0][cell >> 6] & bit) {
+        return 1;
+    } else if (bits[1][cell >> 6] & bit) {
+        return -1;
+    }
+    return 0;
+}
+
+inline bool Board::isEmpty(int cell) const {
+    return !((bits[0][cell >> 6] | bits[1][cell >> 6]) &
+             (uint64_t(1) << (cell & 63)));
+}
+
+inline bool Board::colHasSpace(int col) const {
+    if (col < 0 or col > (cols - 1)) {
+        return false;
+    }
+    return isEmpty(cell(col, rows - 1));
+}
+
+inline bool Board::colNotEmpty(int col) const {
+    return !isEmpty(cell(col, 0));
+}
+
+inline int Board::transform(int cell, int symmetry, int numCols,
+                           int numRows) {
+    const int col = cell / numRows, row = cell % numRows;
+    const int flipCol = numCols - 1 - col, flipRow = numRows - 1 - row;
+    switch (symmetry) {
+    case 1:
+        return flipCol * numRows + row;
+    case 2:
+        return col * numRows + flipRow;
+    case 3:
+        return flipCol * numRows + flipRow;
+    case 4:
+        return row * numRows + col;
+    case 5:
+        return flipRow * numRows + col;
+    case 6:
+        return row * numRows + flipCol;
+    case 7:
+        return flipRow * numRows + flipCol;
+    default:
+        return cell;
+    }
+}
+
+inline int Board::transformCell(int cell, int symmetry) const {
+    return transform(cell, symmetry, cols, rows);
+}
+
+inline int Board::inverseTransformCell(int cell, int symmetry) const {
+    // Every symmetry is its own inverse except the two quarter turns.
+    if (symmetry == 5) {
+        return transformCell(cell, 6);
+    } else if (symmetry == 6) {
+        return transformCell(cell, 5);
+    }
+    return transformCell(cell, symmetry);
+}
+
+inline void Board::updateHashes(int cell, int piece, int numCols,
+                                int numRows, int numSymmetries) {
+    const uint64_t *keys = zobrist[side(piece)];
+    hashKeys[0] ^= keys[cell];
+    for (int s = 1; s < numSymmetries; s++) {
+        hashKeys[s] ^= keys[transform(cell, s, numCols, numRows)];
+    }
+}
+
+inline uint64_t Board::canonicalHash(int &symmetry) const {
+    symmetry = 0;
+    for (int s = 1; s < symmetries; s++) {
+        if (hashKeys[s] < hashKeys[symmetry]) {
+            symmetry = s;
+        }
+    }
+    return hashKeys[symmetry];
+}
+
+inline void Board::placeSized(int cell, int piece, int numCols,
+                              int numRows, int numSymmetries) {
+    bits[side(piece)][cell >> 6] |= uint64_t(1) << (cell & 63);
+    updateHashes(cell, piece, numCols, numRows, numSymmetries);
+    heights[cell / numRows]++;
+    pieces++;
+}
+
+inline void Board::removeSized(int cell, int piece, int numCols,
+                               int numRows, int numSymmetries) {
+    bits[side(piece)][cell >> 6] &= ~(uint64_t(1) << (cell & 63));
+    updateHashes(cell, piece, numCols, numRows, numSymmetries);
+    heights[cell / numRows]--;
+    pieces--;
+}
+
+inline void Board::place(int cell, int piece) {
+    placeSized(cell, piece, cols, rows, symmetries);
+}
+
+inline void Board::remove(int cell, int piece) {
+    removeSized(cell, piece, cols, rows, symmetries);
+}
+
+#endif // BOARD_H
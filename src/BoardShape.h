@@ -0,0 +1,124 @@
+#ifndef BOARDSHAPE_H
+#define BOARDSHAPE_H
+
+#include <cstdint>
+
+// Geometry of a board fixed at compile time, for kernels specialized on the
+// common configurations (7x6 k4 with gravity and 9x7 k5 with and without).
+//
+// Cells are laid out as in Board (cell = col * Rows + row), and the board has
+// to fit in one word per side, so every line test is a fixed number of
+// shifts and ANDs that the compiler unrolls. Tables that do not fit in a
+// constant expression are built once per shape, on first use.
+template <int Cols, int Rows, int K, bool Gravity> class BoardShape {
+  public:
+    static_assert(Cols * Rows <= 64,
+                  "a shape has to fit in one word per side");
+
+    static constexpr bool gravityOn() { return Gravity; }
+    static constexpr int numCols() { return Cols; }
+    static constexpr int numRows() { return Rows; }
+    static constexpr int k() { return K; }
+    static constexpr int numCells() { return Cols * Rows; }
+    // As Board counts them.
+    static constexpr int numSymmetries() {
+        return Gravity ? 2 : Cols != Rows ? 4 : 8;
+    }
+
+  private:
+    // Distance between neighbouring cells of a line, in the directions of
+    // Board: vertical, horizontal, up-right and down-right diagonal.
+    static constexpr int shift(int dir) {
+        return dir == 0 ? 1 : dir == 1 ? Rows : dir == 2 ? Rows + 1 : Rows - 1;
+    }
+
+    // Cells from which a line of K fits on the board in each direction.
+    uint64_t lineStarts[4];
+    // Cells at most one king's move from each cell.
+    uint64_t neighbours[Cols * Rows];
+
+    BoardShape() {
+        const int colStep[4] = {0, 1, 1, 1};
+        const int rowStep[4] = {1, 0, 1, -1};
+        for (int dir = 0; dir < 4; dir++) {
+            lineStarts[dir] = 0;
+            for (int col = 0; col < Cols; col++) {
+                for (int row = 0; row < Rows; row++) {
+                    const int endCol = col + (K - 1) * colStep[dir];
+                    const int endRow = row + (K - 1) * rowStep[dir];
+                    if (endCol < Cols and endRow >= 0 and endRow < Rows) {
+                        lineStarts[dir] |= bit(cell(col, row));
+                    }
+                }
+            }
+        }
+        for (int col = 0; col < Cols; col++) {
+            for (int row = 0; row < Rows; row++) {
+                uint64_t &near = neighbours[cell(col, row)];
+                near = 0;
+                for (int c = col - 1; c <= col + 1; c++) {
+                    for (int r = row - 1; r <= row + 1; r++) {
+                        if (c >= 0 and c < Cols and r >= 0 and r < Rows) {
+                            near |= bit(cell(c, r));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+  public:
+    static const BoardShape &get() {
+        static const BoardShape shape;
+        return shape;
+    }
+
+    static int cell(int col, int row) { return col * Rows + row; }
+    static int colOf(int cell) { return cell / Rows; }
+    static int rowOf(int cell) { return cell % Rows; }
+    static uint64_t bit(int cell) { return uint64_t(1) << cell; }
+
+    // Whether mask has K in a row, by doubling the run found at each cell
+    // until it covers K cells, as Board::hasWin does.
+    bool hasLine(uint64_t mask) const {
+        for (int dir = 0; dir < 4; dir++) {
+            uint64_t run = mask;
+            for (int len = 1; len < K;) {
+                const int step = len < K - len ? len : K - len;
+                run &= run >> (step * shift(dir));
+                len += step;
+            }
+            if (run & lineStarts[dir]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Cells that would give mask K in a row: for each line of K on the
+    // board, its one cell missing from mask when it has all the others.
+    uint64_t winningCells(uint64_t mask) const {
+        uint64_t cells = 0;
+        for (int dir = 0; dir < 4; dir++) {
+            for (int hole = 0; hole < K; hole++) {
+                uint64_t starts = lineStarts[dir];
+                for (int i = 0; i < K; i++) {
+                    if (i != hole) {
+                        starts &= mask >> (i * shift(dir));
+                    }
+                }
+                cells |= starts << (hole * shift(dir));
+            }
+        }
+        return cells & ~mask;
+    }
+
+    uint64_t neighboursOf(int cell) const { return neighbours[cell]; }
+};
+
+// The shapes the kernels are compiled for.
+typedef BoardShape<7, 6, 4, true> Connect4;
+typedef BoardShape<9, 7, 5, true> Gravity9x7;
+typedef BoardShape<9, 7, 5, false> Open9x7;
+
+#endif // BOARDSHAPE_H
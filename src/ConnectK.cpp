@@ -1,17 +1,149 @@
 #include "AIShell.h"
+#include "Batch.h"
+#include "Board.h"
+#include "Match.h"
 #include "Move.h"
-// #include <cstdio>
-// #include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
 bool isFirstPlayer = false;
+SearchOptions options;
+vector<int> gameState; // cells of the last request, reused by the next
+string batchFile;       // positions to analyse instead of playing, or ""
+int batchWorkers = 0;   // threads analysing them or playing the match; 0 for
+                        // one per core
+int matchGames = 0;     // games against an opponent instead of playing, or 0
+string opponentArgs;    // search options of an opponent of this build
+string opponentCommand; // program playing the opponent instead, or ""
+vector<MatchRules> matchRules; // of the random openings
+string openingsFile;           // openings to play instead, or ""
+int openingPlies = 2;          // moves of a random opening
+unsigned matchSeed = 1;        // of the random openings
+int moveTimeMs = 100;          // deadline of each match move; 0 for none
 
-AIShell *makeAIShellFromInput() {
-    AIShell *shell = NULL;
+// Reads one --name=value search setting into searchOptions. Returns false if
+// arg is not one.
+bool parseSearchOption(const string &arg, SearchOptions &searchOptions) {
+    size_t eq = arg.find('=');
+    string name = arg.substr(0, eq);
+    string value = (eq == string::npos) ? "" : arg.substr(eq + 1);
+    if (name == "--hash") {
+        searchOptions.hashSizeMb = atoi(value.c_str());
+    } else if (name == "--symmetry") {
+        searchOptions.symmetry = atoi(value.c_str()) != 0;
+    } else if (name == "--depth") {
+        searchOptions.maxDepth = max(0, atoi(value.c_str()));
+    } else if (name == "--threads") {
+        searchOptions.threads = max(1, atoi(value.c_str()));
+    } else if (name == "--ybw") {
+        searchOptions.ybw = atoi(value.c_str()) != 0;
+    } else if (name == "--split-depth") {
+        searchOptions.splitDepth = max(1, atoi(value.c_str()));
+    } else if (name == "--ponder") {
+        searchOptions.ponder = atoi(value.c_str()) != 0;
+    } else if (name == "--time-margin") {
+        searchOptions.timeMarginMs = max(0, atoi(value.c_str()));
+    } else if (name == "--search" and value == "alphabeta") {
+        searchOptions.algorithm = SearchOptions::ALPHA_BETA;
+    } else if (name == "--search" and value == "pvs") {
+        searchOptions.algorithm = SearchOptions::PVS;
+    } else if (name == "--search" and value == "mtdf") {
+        searchOptions.algorithm = SearchOptions::MTDF;
+    } else if (name == "--aspiration") {
+        searchOptions.aspiration = atoi(value.c_str()) != 0;
+    } else if (name == "--lmr") {
+        searchOptions.lmrMoves = max(0, atoi(value.c_str()));
+    } else if (name == "--lmr-depth") {
+        searchOptions.lmrDepth = max(2, atoi(value.c_str()));
+    } else if (name == "--prune-depth") {
+        searchOptions.pruneDepth = max(0, atoi(value.c_str()));
+    } else if (name == "--prune-distance") {
+        searchOptions.pruneDistance = max(1, atoi(value.c_str()));
+    } else if (name == "--threat-depth") {
+        searchOptions.threatDepth = max(0, atoi(value.c_str()));
+    } else if (name == "--threat-leaves") {
+        searchOptions.threatLeaves = atoi(value.c_str()) != 0;
+    } else if (name == "--eval" and value == "wins") {
+        searchOptions.patternEval = false;
+    } else if (name == "--eval" and value == "patterns") {
+        searchOptions.patternEval = true;
+    } else if (name == "--solve") {
+        searchOptions.solveCells = max(0, atoi(value.c_str()));
+    } else if (name == "--solve-hash") {
+        searchOptions.solveHashMb = max(1, atoi(value.c_str()));
+    } else if (name == "--engine" and value == "minimax") {
+        searchOptions.engine = SearchOptions::MINIMAX;
+    } else if (name == "--engine" and value == "mcts") {
+        searchOptions.engine = SearchOptions::MCTS;
+    } else if (name == "--engine" and value == "auto") {
+        searchOptions.engine = SearchOptions::AUTO;
+    } else if (name == "--mcts-memory") {
+        searchOptions.mctsMb = max(1, atoi(value.c_str()));
+    } else if (name == "--mcts-policy" and value == "random") {
+        searchOptions.mctsLight = false;
+    } else if (name == "--mcts-policy" and value == "light") {
+        searchOptions.mctsLight = true;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Reads --name=value settings from the command line into options.
+void parseOptions(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        string name = arg.substr(0, eq);
+        string value = (eq == string::npos) ? "" : arg.substr(eq + 1);
+        if (name == "--batch" and !value.empty()) {
+            batchFile = value;
+        } else if (name == "--workers") {
+            batchWorkers = max(1, atoi(value.c_str()));
+        } else if (name == "--match") {
+            matchGames = max(1, atoi(value.c_str()));
+        } else if (name == "--opponent") {
+            opponentArgs = value;
+        } else if (name == "--opponent-cmd" and !value.empty()) {
+            opponentCommand = value;
+        } else if (name == "--rules") {
+            MatchRules rules;
+            int gravity;
+            char comma1, comma2, comma3;
+            istringstream fields(value);
+            if (fields >> gravity >> comma1 >> rules.numCols >> comma2 >>
+                    rules.numRows >> comma3 >> rules.k and
+                comma1 == ',' and comma2 == ',' and comma3 == ',') {
+                rules.gravityOn = gravity != 0;
+                matchRules.push_back(rules);
+            } else {
+                cerr << "bad rules " << value << endl;
+            }
+        } else if (name == "--openings" and !value.empty()) {
+            openingsFile = value;
+        } else if (name == "--opening-plies") {
+            openingPlies = max(0, atoi(value.c_str()));
+        } else if (name == "--seed") {
+            matchSeed = strtoul(value.c_str(), nullptr, 10);
+        } else if (name == "--move-time") {
+            moveTimeMs = max(0, atoi(value.c_str()));
+        } else if (!parseSearchOption(arg, options)) {
+            cerr << "unrecognized option " << arg << endl;
+        }
+    }
+}
 
+// Reads the next move request into shell.
+void readMoveRequest(AIShell &shell) {
     string begin = "makeMoveWithState:";
     string end = "end";
     string input;
@@ -19,6 +151,7 @@ AIShell *makeAIShellFromInput() {
     while (go) {
         cin >> input;
         if (input == end) {
+            shell.stopPondering();
             exit(0);
         } else if (input == begin) {
             // first I want the gravity, then number of cols, then number of
@@ -58,22 +191,26 @@ AIShell *makeAIShellFromInput() {
             cin >> g;
             int k = g;
 
-            // now the values for each space.
-
-            // allocate 2D array.
-            int **gameState = NULL;
-            gameState = new int *[colCount];
-            for (int i = 0; i < colCount; i++) {
-                gameState[i] = new int[rowCount];
+            // The board is kept in fixed-size bitboards; a larger one
+            // cannot be played.
+            if (!Board::fits(colCount, rowCount)) {
+                cerr << "unsupported board size " << colCount << "x"
+                     << rowCount << ": at most " << Board::MAX_COLS
+                     << " columns and " << Board::MAX_CELLS << " cells"
+                     << endl;
+                shell.stopPondering();
+                exit(1);
             }
 
+            // now the values for each space.
+
+            // column by column, as the Board lays out its cells.
+            gameState.resize(colCount * rowCount);
             int countMoves = 0;
-            for (int col = 0; col < colCount; col++) {
-                for (int row = 0; row < rowCount; row++) {
-                    cin >> gameState[col][row];
-                    if (gameState[col][row] != AIShell::NO_PIECE) {
-                        countMoves += gameState[col][row];
-                    }
+            for (int cell = 0; cell < colCount * rowCount; cell++) {
+                cin >> gameState[cell];
+                if (gameState[cell] != AIShell::NO_PIECE) {
+                    countMoves += gameState[cell];
                 }
             }
 
@@ -82,19 +219,14 @@ AIShell *makeAIShellFromInput() {
             }
 
             Move m(lastMoveCol, lastMoveRow);
-            AIShell *shell = new AIShell(gravity, colCount, rowCount, k,
-                                         gameState, m, deadline);
-            // shell->deadline = deadline;
-            // shell->k = k;
-
-            return shell;
+            shell.setState(gravity, colCount, rowCount, k, gameState, m,
+                           deadline);
+            return;
         } else {
             cout << "unrecognized command " << input << endl;
         }
         // otherwise loop back to the top and wait for proper input.
     }
-
-    return shell;
 }
 
 void returnMove(Move move) {
@@ -108,17 +240,132 @@ bool checkIfFirstPlayer() {
     return isFirstPlayer;
 }
 
-int main() {
+// Analyses the positions of batchFile ("-" for the standard input), writing
+// a line per position to the standard output and a summary to the standard
+// error. Returns the exit status.
+int runBatchFile() {
+    ifstream file;
+    if (batchFile != "-") {
+        file.open(batchFile);
+        if (!file) {
+            cerr << "cannot open " << batchFile << endl;
+            return 1;
+        }
+    }
+    vector<BatchPosition> positions;
+    string error;
+    if (!readBatch(batchFile == "-" ? cin : file, positions, error)) {
+        cerr << error << endl;
+        return 1;
+    }
+
+    int workers = batchWorkers;
+    if (workers == 0) {
+        workers = max(1, int(thread::hardware_concurrency()) / options.threads);
+    }
+    const auto start = chrono::steady_clock::now();
+    const vector<BatchResult> results =
+        runBatch(positions, options, workers, &cout);
+    const double seconds =
+        max(chrono::duration<double>(chrono::steady_clock::now() - start)
+                .count(),
+            1e-3);
+    long long nodes = 0;
+    for (auto &result : results) {
+        nodes += result.report.nodes;
+    }
+    cerr << positions.size() << " positions on " << workers << " workers in "
+         << seconds << "s: " << positions.size() / seconds
+         << " positions/s, " << (long long)(nodes / seconds) << " nodes/s."
+         << endl;
+    return 0;
+}
+
+// Plays matchGames games of this build, with options, against the opponent
+// on --workers threads, writing a line per game and then a summary to the
+// standard output. Returns the exit status.
+int runMatchGames() {
+    MatchPlayer engine;
+    engine.name = "engine";
+    engine.options = options;
+    MatchPlayer opponent;
+    opponent.options = options;
+    opponent.command = opponentCommand;
+    istringstream args(opponentArgs);
+    string arg;
+    while (args >> arg) {
+        if (!parseSearchOption(arg, opponent.options)) {
+            cerr << "unrecognized opponent option " << arg << endl;
+            return 1;
+        }
+    }
+    const string &described =
+        opponentCommand.empty() ? opponentArgs : opponentCommand;
+    opponent.name =
+        described.empty() ? "opponent" : "opponent (" + described + ")";
+    if (moveTimeMs == 0 and
+        (engine.options.maxDepth == 0 or
+         (opponentCommand.empty() and opponent.options.maxDepth == 0))) {
+        cerr << "a match without --move-time needs a --depth" << endl;
+        return 1;
+    }
+
+    vector<MatchOpening> openings;
+    if (!openingsFile.empty()) {
+        ifstream file(openingsFile);
+        if (!file) {
+            cerr << "cannot open " << openingsFile << endl;
+            return 1;
+        }
+        string error;
+        if (!readOpenings(file, openings, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        if (openings.empty()) {
+            cerr << "no openings in " << openingsFile << endl;
+            return 1;
+        }
+    } else {
+        if (matchRules.empty()) {
+            matchRules.push_back(MatchRules());
+        }
+        openings = randomOpenings(matchRules, (matchGames + 1) / 2,
+                                  openingPlies, matchSeed);
+    }
+
+    MatchSettings settings;
+    settings.games = matchGames;
+    settings.moveTimeMs = moveTimeMs;
+    settings.workers = batchWorkers;
+    if (settings.workers == 0) {
+        settings.workers =
+            max(1, int(thread::hardware_concurrency()) / options.threads);
+    }
+    const MatchResult result =
+        runMatch(engine, opponent, openings, settings, &cout);
+    writeMatchSummary(cout, engine, opponent, result);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    parseOptions(argc, argv);
+    if (!batchFile.empty()) {
+        return runBatchFile();
+    }
+    if (matchGames > 0) {
+        return runMatchGames();
+    }
     cout << "Make sure this program is ran by the Java shell. It is incomplete "
             "on its own. "
          << endl;
+    AIShell shell(options);
     bool go = true;
-    while (go) { // do this forever until the makeAIShellFromInput function ends
+    while (go) { // do this forever until the readMoveRequest function ends
         // the process or it is killed by the java wrapper.
-        AIShell *shell = makeAIShellFromInput();
-        Move moveMade = shell->makeMove();
+        readMoveRequest(shell);
+        Move moveMade = shell.makeMove();
         returnMove(moveMade);
-        delete shell;
     }
 
     return 0;
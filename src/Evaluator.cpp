@@ -0,0 +1,90 @@
+#include "Evaluator.h"
+
+namespace {
+// Lines of length cells on the board, in all four directions: the first
+// cell of each and the step to the next one. linesOfCell gets the index of
+// every line through each cell, and powers the place value of the cell in
+// it, 3^i for its i-th cell.
+void findLines(const Board &board, int length, std::vector<int> &starts,
+               std::vector<int> &steps,
+               std::vector<std::vector<int>> &linesOfCell,
+               std::vector<std::vector<uint32_t>> &powers) {
+    const int numCols = board.numCols();
+    const int numRows = board.numRows();
+    const int colStep[Board::NUM_DIRECTIONS] = {0, 1, 1, 1};
+    const int rowStep[Board::NUM_DIRECTIONS] = {1, 0, 1, -1};
+    linesOfCell.assign(board.numCells(), std::vector<int>());
+    powers.assign(board.numCells(), std::vector<uint32_t>());
+
+    // Enumerate lines by their starting cell, recording which cells each
+    // one covers.
+    for (int dir = 0; dir < Board::NUM_DIRECTIONS; dir++) {
+        for (int col = 0; col < numCols; col++) {
+            for (int row = 0; row < numRows; row++) {
+                const int endCol = col + (length - 1) * colStep[dir];
+                const int endRow = row + (length - 1) * rowStep[dir];
+                if (length <= 0 or endCol >= numCols or endRow < 0 or
+                    endRow >= numRows) {
+                    continue;
+                }
+                uint32_t power = 1;
+                for (int i = 0; i < length; i++, power *= 3) {
+                    const int cell = board.cell(col + i * colStep[dir],
+                                                row + i * rowStep[dir]);
+                    linesOfCell[cell].push_back(starts.size());
+                    powers[cell].push_back(power);
+                }
+                starts.push_back(board.cell(col, row));
+                steps.push_back(colStep[dir] * numRows + rowStep[dir]);
+            }
+        }
+    }
+}
+
+// Flattens the lines of each cell into one array, cell after cell.
+template <typename T>
+void flatten(const std::vector<std::vector<T>> &ofCell,
+             std::vector<int> &first, std::vector<T> &flat) {
+    first.assign(ofCell.size() + 1, 0);
+    for (int cell = 0; cell < int(ofCell.size()); cell++) {
+        first[cell] = flat.size();
+        flat.insert(flat.end(), ofCell[cell].begin(), ofCell[cell].end());
+    }
+    first[ofCell.size()] = flat.size();
+}
+} // namespace
+
+Evaluator::Evaluator(const Board &board, bool withPatterns)
+    : k{board.k()}, windows{0} {
+    std::vector<std::vector<int>> windowsOfCell;
+    std::vector<std::vector<uint32_t>> powers;
+    findLines(board, k, windowStart, windowStep, windowsOfCell, powers);
+    windows = windowStart.size();
+    flatten(windowsOfCell, firstWindow, cellWindows);
+
+    counts.assign(windows * 2, 0);
+    possibleWins[0] = possibleWins[1] = windows;
+    wins[0] = wins[1] = 0;
+    threatCells[0] = threatCells[1] = 0;
+
+    if (withPatterns and k >= 1 and k <= Patterns::MAX_K) {
+        patterns = &Patterns::forK(k);
+        std::vector<int> firstPower;
+        flatten(powers, firstPower, cellPowers);
+        codes.assign(windows, 0);
+
+        std::vector<int> frameStart, frameStep;
+        std::vector<std::vector<int>> framesOfCell;
+        findLines(board, k + 1, frameStart, frameStep, framesOfCell, powers);
+        flatten(framesOfCell, firstFrame, cellFrames);
+        flatten(powers, firstPower, framePowers);
+        frameCodes.assign(frameStart.size(), 0);
+        foursAt.assign(board.numCells() * 2, 0);
+    }
+
+    for (int cell = 0; cell < board.numCells(); cell++) {
+        if (!board.isEmpty(cell)) {
+            place(cell, board.pieceAt(cell));
+        }
+    }
+}
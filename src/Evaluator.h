@@ -0,0 +1,174 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "Board.h"
+#include "Patterns.h"
+#include <cstdint>
+#include <vector>
+
+// Incrementally maintained version of the possible-wins heuristic.
+//
+// Every k-window on the board (in all four directions) keeps a count of the
+// pieces each side has in it. A window with no opponent piece is a possible
+// win for the player and vice versa; a window filled by one side is a win.
+// Placing or removing a piece only touches the windows through that cell, so
+// keeping the totals up to date costs O(4k) instead of a full board sweep.
+//
+// With patterns on, every window and every frame of k + 1 cells also keeps
+// the base-3 code of its cells, and the total of what the Patterns tables
+// give for them; the cells that would complete a four of each side are
+// counted too. An update is still one step per window or frame.
+class Evaluator {
+    int k;
+    int windows;
+    // Windows through each cell, stored contiguously: the windows of cell c
+    // are cellWindows[firstWindow[c]] to cellWindows[firstWindow[c + 1] - 1].
+    std::vector<int> firstWindow;
+    std::vector<int> cellWindows;
+    // Cells of each window: windowStart[w] + i * windowStep[w] for i < k.
+    std::vector<int> windowStart;
+    std::vector<int> windowStep;
+    // Pieces per window, interleaved as [window * 2 + side].
+    std::vector<uint8_t> counts;
+    int possibleWins[2];
+    int wins[2];
+    // Pattern scoring, when patterns is set. cellPowers runs parallel to
+    // cellWindows with the place value of the cell in each window, and
+    // cellFrames and framePowers are the same for the frames.
+    const Patterns *patterns = nullptr;
+    std::vector<uint32_t> cellPowers;
+    std::vector<uint32_t> codes; // per window
+    std::vector<int> firstFrame;
+    std::vector<int> cellFrames;
+    std::vector<uint32_t> framePowers;
+    std::vector<uint32_t> frameCodes;
+    int patternTotal = 0;
+    // Fours of each side that lack a cell, as [cell * 2 + side], and the
+    // number of cells with at least one.
+    std::vector<uint8_t> foursAt;
+    int threatCells[2];
+
+    void addFour(int window, const Patterns::Window &four, int change);
+    void updatePatterns(int cell, int piece, int sign);
+
+    static int side(int piece) { return piece > 0 ? 0 : 1; }
+
+  public:
+    // With withPatterns the evaluator also scores patterns, if the board's
+    // k is at most Patterns::MAX_K.
+    explicit Evaluator(const Board &board, bool withPatterns = false);
+
+    int numWindows() const { return windows; }
+    int maxPossibleWins() const { return possibleWins[0]; }
+    int minPossibleWins() const { return possibleWins[1]; }
+    int maxWins() const { return wins[0]; }
+    int minWins() const { return wins[1]; }
+    bool hasPatterns() const { return patterns != nullptr; }
+    // Sum of the pattern scores of all windows and frames, for the player.
+    int patternScore() const { return patternTotal; }
+    // Empty cells on which the side of piece would complete a four.
+    int threatCellsOf(int piece) const { return threatCells[side(piece)]; }
+    // Windows through a cell, and the cells and pieces of a window.
+    const int *windowsOf(int cell) const {
+        return cellWindows.data() + firstWindow[cell];
+    }
+    int numWindowsOf(int cell) const {
+        return firstWindow[cell + 1] - firstWindow[cell];
+    }
+    int windowCell(int window, int i) const {
+        return windowStart[window] + i * windowStep[window];
+    }
+    int piecesIn(int window, int piece) const {
+        return counts[window * 2 + side(piece)];
+    }
+    // Most pieces one side has in a window through cell that the other side
+    // has not blocked. A move there at k - 2 or more makes or stops a threat.
+    int mostInOpenWindow(int cell) const;
+
+    void place(int cell, int piece);
+    void remove(int cell, int piece);
+};
+
+inline void Evaluator::place(int cell, int piece) {
+    const int own = side(piece);
+    const int other = 1 - own;
+    for (int i = firstWindow[cell]; i < firstWindow[cell + 1]; i++) {
+        uint8_t &count = counts[cellWindows[i] * 2 + own];
+        if (count == 0) {
+            possibleWins[other]--;
+        }
+        if (++count == k) {
+            wins[own]++;
+        }
+    }
+    if (patterns) {
+        updatePatterns(cell, piece, 1);
+    }
+}
+
+inline void Evaluator::remove(int cell, int piece) {
+    const int own = side(piece);
+    const int other = 1 - own;
+    for (int i = firstWindow[cell]; i < firstWindow[cell + 1]; i++) {
+        uint8_t &count = counts[cellWindows[i] * 2 + own];
+        if (count == k) {
+            wins[own]--;
+        }
+        if (--count == 0) {
+            possibleWins[other]++;
+        }
+    }
+    if (patterns) {
+        updatePatterns(cell, piece, -1);
+    }
+}
+
+inline void Evaluator::addFour(int window, const Patterns::Window &four,
+                               int change) {
+    const int cell = windowCell(window, four.hole);
+    uint8_t &fours = foursAt[cell * 2 + side(four.owner)];
+    if (change > 0 ? fours++ == 0 : --fours == 0) {
+        threatCells[side(four.owner)] += change;
+    }
+}
+
+// Moves the codes of the windows and frames through cell by a piece put
+// there (sign 1) or taken away (sign -1), and the totals with them.
+inline void Evaluator::updatePatterns(int cell, int piece, int sign) {
+    const uint32_t digit = Patterns::digit(piece);
+    for (int i = firstWindow[cell]; i < firstWindow[cell + 1]; i++) {
+        const int window = cellWindows[i];
+        uint32_t &code = codes[window];
+        const Patterns::Window &before = patterns->window(code);
+        code += sign * digit * cellPowers[i];
+        const Patterns::Window &after = patterns->window(code);
+        patternTotal += after.score - before.score;
+        if (before.hole >= 0) {
+            addFour(window, before, -1);
+        }
+        if (after.hole >= 0) {
+            addFour(window, after, 1);
+        }
+    }
+    for (int i = firstFrame[cell]; i < firstFrame[cell + 1]; i++) {
+        uint32_t &code = frameCodes[cellFrames[i]];
+        const int before = patterns->frame(code);
+        code += sign * digit * framePowers[i];
+        patternTotal += patterns->frame(code) - before;
+    }
+}
+
+inline int Evaluator::mostInOpenWindow(int cell) const {
+    int most = 0;
+    for (int i = firstWindow[cell]; i < firstWindow[cell + 1]; i++) {
+        const uint8_t *count = &counts[cellWindows[i] * 2];
+        if (count[1] == 0 and count[0] > most) {
+            most = count[0];
+        } else if (count[0] == 0 and count[1] > most) {
+            most = count[1];
+        }
+    }
+    return most;
+}
+
+#endif // EVALUATOR_H
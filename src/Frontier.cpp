@@ -0,0 +1,32 @@
+#include "Frontier.h"
+#include <algorithm>
+
+Frontier::Frontier(const Board &board, int reach)
+    : numCells{board.numCells()},
+      reach{std::max(0, std::min(reach, MAX_REACH))},
+      stride{board.numRows() + 2 * this->reach}, index(board.numCells()) {
+    std::fill(occupied, occupied + Board::MAX_WORDS, uint64_t(0));
+    for (int cell = 0; cell < numCells; cell++) {
+        index[cell] = (board.colOf(cell) + this->reach) * stride +
+                      board.rowOf(cell) + this->reach;
+    }
+
+    // A column of a square is 2 * reach + 1 counts, and the words that add
+    // to it may run over into the padding of the next column.
+    const int side = 2 * this->reach + 1;
+    uint8_t bytes[2 * MAX_REACH + 8] = {};
+    std::fill(bytes, bytes + side, uint8_t(1));
+    ones.resize((side + 7) / 8);
+    for (size_t w = 0; w < ones.size(); w++) {
+        std::memcpy(&ones[w], bytes + w * 8, 8);
+    }
+    nearCounts.assign((board.numCols() + 2 * this->reach) * stride +
+                          ones.size() * 8,
+                      0);
+
+    for (int cell = 0; cell < numCells; cell++) {
+        if (!board.isEmpty(cell)) {
+            place(cell);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include "Board.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// The empty cells within reach (in kings' moves) of a piece, which are the
+// moves worth trying on a board without gravity.
+//
+// Every cell counts the pieces within reach of it, and the frontier is the
+// set of empty cells whose count is not zero. Placing or removing a piece
+// only touches the counts of the square around it, so keeping the frontier
+// up to date costs O(reach^2) whatever the size of the board, and a cell is
+// tested with one load. The counts are bytes kept in columns padded by reach
+// cells on every side, so that no square is clipped by the edges and each
+// column of one is updated eight counts at a time.
+class Frontier {
+  public:
+    // Farthest reach: the counts of a square of 2 * 7 + 1 cells a side fit
+    // a byte.
+    static const int MAX_REACH = 7;
+
+  private:
+    int numCells;
+    int reach;
+    int stride;             // counts from a column to the next
+    std::vector<int> index; // of the count of each cell
+    // Added to the counts of a square, one word per column for every eight
+    // of its cells.
+    std::vector<uint64_t> ones;
+    std::vector<uint8_t> nearCounts; // pieces within reach of each cell
+    uint64_t occupied[Board::MAX_WORDS];
+
+    static uint64_t bit(int cell) { return uint64_t(1) << (cell & 63); }
+    void add(int cell, bool placed);
+
+  public:
+    // Starts from the pieces already on board. reach is capped at MAX_REACH.
+    Frontier(const Board &board, int reach);
+
+    bool contains(int cell) const {
+        return nearCounts[index[cell]] and !(occupied[cell >> 6] & bit(cell));
+    }
+    // Whether an empty cell is on the frontier.
+    bool containsEmpty(int cell) const { return nearCounts[index[cell]]; }
+    // Writes the cells of the frontier into moves, in increasing order, and
+    // returns how many there are.
+    int list(int *moves) const;
+
+    void place(int cell) {
+        occupied[cell >> 6] |= bit(cell);
+        add(cell, true);
+    }
+    void remove(int cell) {
+        occupied[cell >> 6] &= ~bit(cell);
+        add(cell, false);
+    }
+};
+
+// A count never leaves 0 to 255, so adding or subtracting a whole word never
+// carries from one count into the next.
+inline void Frontier::add(int cell, bool placed) {
+    uint8_t *column = &nearCounts[index[cell] - reach * stride - reach];
+    for (int x = 0; x <= 2 * reach; x++, column += stride) {
+        for (size_t w = 0; w < ones.size(); w++) {
+            uint64_t counts;
+            std::memcpy(&counts, column + w * 8, 8);
+            counts = placed ? counts + ones[w] : counts - ones[w];
+            std::memcpy(column + w * 8, &counts, 8);
+        }
+    }
+}
+
+inline int Frontier::list(int *moves) const {
+    int count = 0;
+    for (int cell = 0; cell < numCells; cell++) {
+        if (contains(cell)) {
+            moves[count++] = cell;
+        }
+    }
+    return count;
+}
+
+#endif // FRONTIER_H
@@ -0,0 +1,593 @@
+#include "Match.h"
+#include "Board.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <random>
+#include <sstream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+// Deadline of a move limited by depth only.
+static const int NO_TIME_LIMIT = INT_MAX;
+// Normal quantile of a two-sided 95% confidence interval.
+static const double Z_95 = 1.959964;
+// How long a program gets to exit once told the match is over.
+static const int EXIT_WAIT_MS = 1000;
+// How far past the deadline a move may arrive, for the time it takes to
+// pass the request and the answer, before the side loses on time.
+static const int TIME_GRACE_MS = 200;
+
+// Serialises starting programs, so that no child inherits the pipes of
+// another before they are marked close-on-exec.
+mutex spawnLock;
+
+// One side of the games of a worker.
+class Player {
+  public:
+    virtual ~Player() {}
+    // Answers a move request: cells are seen from the player, whose pieces
+    // are AIShell::PLAYER_PIECE, and lastMove is the other side's, or
+    // (-1, -1) if there is none. Returns false if no move came back.
+    virtual bool move(const MatchRules &rules, const vector<int> &cells,
+                      Move lastMove, int deadline, Move &move) = 0;
+    // How the last move was found, if the player can tell.
+    virtual const AIShell::Report *report() const { return nullptr; }
+};
+
+class ShellPlayer : public Player {
+    AIShell shell;
+
+  public:
+    explicit ShellPlayer(const SearchOptions &options) : shell(options) {}
+
+    bool move(const MatchRules &rules, const vector<int> &cells,
+              Move lastMove, int deadline, Move &move) override {
+        shell.setState(rules.gravityOn, rules.numCols, rules.numRows, rules.k,
+                       cells, lastMove, deadline);
+        move = shell.makeMove();
+        return true;
+    }
+    const AIShell::Report *report() const override {
+        return &shell.lastReport();
+    }
+};
+
+// A program started by /bin/sh on the first request and kept running from
+// one game to the next, as the Java shell does. It is restarted after it
+// fails to answer in time.
+class ProgramPlayer : public Player {
+    const string command;
+    pid_t pid = -1;
+    FILE *toProgram = nullptr;
+    int fromProgram = -1; // read without stdio, so that it can be polled
+    string pending;       // read from the program, not yet a whole line
+
+    bool start();
+    void stop();
+    bool readLine(string &line, Clock::time_point until);
+
+  public:
+    explicit ProgramPlayer(const string &command) : command(command) {}
+    ~ProgramPlayer() override { stop(); }
+
+    bool move(const MatchRules &rules, const vector<int> &cells,
+              Move lastMove, int deadline, Move &move) override;
+};
+
+bool ProgramPlayer::start() {
+    lock_guard<mutex> guard(spawnLock);
+    int input[2], output[2]; // the program's standard input and output
+    if (pipe(input) != 0) {
+        return false;
+    }
+    if (pipe(output) != 0) {
+        close(input[0]);
+        close(input[1]);
+        return false;
+    }
+    for (int fd : {input[0], input[1], output[0], output[1]}) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    pid = fork();
+    if (pid == 0) {
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        signal(SIGPIPE, SIG_DFL); // ignored by the match, not the program
+        execl("/bin/sh", "sh", "-c", command.c_str(), (char *)nullptr);
+        _exit(127);
+    }
+    close(input[0]);
+    close(output[1]);
+    if (pid < 0) {
+        close(input[1]);
+        close(output[0]);
+        return false;
+    }
+    toProgram = fdopen(input[1], "w");
+    fromProgram = output[0];
+    pending.clear();
+    if (!toProgram) {
+        close(input[1]);
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void ProgramPlayer::stop() {
+    if (toProgram) {
+        fputs("end\n", toProgram);
+        fclose(toProgram);
+        toProgram = nullptr;
+    }
+    if (fromProgram >= 0) {
+        close(fromProgram);
+        fromProgram = -1;
+    }
+    if (pid <= 0) {
+        return;
+    }
+    for (int waited = 0; waitpid(pid, nullptr, WNOHANG) == 0; waited += 10) {
+        if (waited >= EXIT_WAIT_MS) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            break;
+        }
+        this_thread::sleep_for(milliseconds(10));
+    }
+    pid = -1;
+}
+
+// Takes the next line the program writes, waiting for it until until at
+// most. Returns false if none came by then or the program closed its output.
+bool ProgramPlayer::readLine(string &line, Clock::time_point until) {
+    for (;;) {
+        const size_t end = pending.find('\n');
+        if (end != string::npos) {
+            line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            return true;
+        }
+        int timeoutMs = -1;
+        if (until != Clock::time_point::max()) {
+            const auto left = duration_cast<milliseconds>(until - Clock::now());
+            timeoutMs = max(0, int(left.count()));
+        }
+        pollfd ready = {fromProgram, POLLIN, 0};
+        const int events = poll(&ready, 1, timeoutMs);
+        if (events < 0 and errno == EINTR) {
+            continue;
+        }
+        if (events <= 0) {
+            return false;
+        }
+        char buffer[4096];
+        const ssize_t count = read(fromProgram, buffer, sizeof(buffer));
+        if (count < 0 and errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        pending.append(buffer, count);
+    }
+}
+
+bool ProgramPlayer::move(const MatchRules &rules, const vector<int> &cells,
+                         Move lastMove, int deadline, Move &move) {
+    if (!toProgram and !start()) {
+        return false;
+    }
+    fprintf(toProgram, "makeMoveWithState: %d %d %d %d %d %d %d",
+            rules.gravityOn ? 1 : 0, rules.numCols, rules.numRows,
+            lastMove.col, lastMove.row, deadline, rules.k);
+    for (int piece : cells) {
+        fprintf(toProgram, " %d", piece);
+    }
+    fputc('\n', toProgram);
+    if (fflush(toProgram) != 0) {
+        stop();
+        return false;
+    }
+    // Anything before the answer, such as a banner, is skipped.
+    const Clock::time_point until =
+        deadline == NO_TIME_LIMIT
+            ? Clock::time_point::max()
+            : Clock::now() + milliseconds(deadline + TIME_GRACE_MS);
+    string line;
+    bool answered = false;
+    while (!answered and readLine(line, until)) {
+        answered = sscanf(line.c_str(), "ReturningTheMoveMade %d %d",
+                          &move.col, &move.row) == 2;
+    }
+    if (!answered) {
+        stop();
+    }
+    return answered;
+}
+
+unique_ptr<Player> makePlayer(const MatchPlayer &player) {
+    if (player.command.empty()) {
+        return unique_ptr<Player>(new ShellPlayer(player.options));
+    }
+    return unique_ptr<Player>(new ProgramPlayer(player.command));
+}
+
+// Plays the moves of opening on board, first player first, and returns why
+// it cannot start a game, or an empty string if it can.
+string playOpening(const MatchOpening &opening, Board &board) {
+    int piece = AIShell::PLAYER_PIECE;
+    for (const Move &move : opening.moves) {
+        if (move.col < 0 or move.col >= board.numCols() or move.row < 0 or
+            move.row >= board.numRows()) {
+            return "move off the board";
+        }
+        const int cell = board.cell(move.col, move.row);
+        if (!board.isEmpty(cell)) {
+            return "move on a taken cell";
+        }
+        if (board.gravityOn() and board.height(move.col) != move.row) {
+            return "piece above an empty cell";
+        }
+        board.place(cell, piece);
+        if (board.hasWin(piece)) {
+            return "game is already won";
+        }
+        piece = -piece;
+    }
+    if (board.numPieces() == board.numCells()) {
+        return "board is full";
+    }
+    return "";
+}
+
+string checkRules(const MatchRules &rules) {
+    if (!Board::fits(rules.numCols, rules.numRows)) {
+        return "unsupported board size";
+    }
+    if (rules.k < 1 or rules.k > max(rules.numCols, rules.numRows)) {
+        return "k does not fit the board";
+    }
+    return "";
+}
+
+// Plays one game from opening and returns how it ended. players[0] is the
+// engine; stats[i] adds up what players[i] did.
+GameRecord playGame(Player *const players[2], const MatchOpening &opening,
+                    bool engineFirst, int deadline, SideStats stats[2]) {
+    const MatchRules &rules = opening.rules;
+    Board board(rules.gravityOn, rules.numCols, rules.numRows, rules.k);
+    playOpening(opening, board);
+    Move lastMove =
+        opening.moves.empty() ? Move(-1, -1) : opening.moves.back();
+    int piece = opening.moves.size() % 2 == 0 ? AIShell::PLAYER_PIECE
+                                              : AIShell::OPPONENT_PIECE;
+    const int enginePiece =
+        engineFirst ? AIShell::PLAYER_PIECE : AIShell::OPPONENT_PIECE;
+
+    GameRecord record;
+    record.engineFirst = engineFirst;
+    vector<int> cells(board.numCells());
+    while (board.numPieces() < board.numCells()) {
+        const int side = piece == enginePiece ? 0 : 1;
+        for (int cell = 0; cell < board.numCells(); cell++) {
+            cells[cell] = board.pieceAt(cell) * piece;
+        }
+        Move move;
+        const Clock::time_point start = Clock::now();
+        const bool answered =
+            players[side]->move(rules, cells, lastMove, deadline, move);
+        const long long timeMs =
+            duration_cast<milliseconds>(Clock::now() - start).count();
+        stats[side].timeMs += timeMs;
+        stats[side].moves++;
+        const AIShell::Report *report = players[side]->report();
+        if (report and strcmp(report->source, "opening") != 0) {
+            stats[side].reported++;
+            stats[side].nodes += report->nodes;
+        }
+        if (report and strcmp(report->source, "search") == 0) {
+            stats[side].searched++;
+            stats[side].depths += report->depth;
+            if (deadline != NO_TIME_LIMIT) {
+                stats[side].savedMs += report->timeSavedMs;
+                stats[side].wastedMs += report->timeWastedMs;
+            }
+        }
+
+        const int loser = side == 0 ? -1 : 1;
+        if (deadline != NO_TIME_LIMIT and timeMs > deadline + TIME_GRACE_MS) {
+            record.result = loser;
+            record.end = "time";
+            return record;
+        }
+        if (!answered) {
+            record.result = loser;
+            record.end = "no move";
+            return record;
+        }
+        if (move.col < 0 or move.col >= board.numCols() or move.row < 0 or
+            move.row >= board.numRows() or
+            !board.isEmpty(move.col, move.row) or
+            (board.gravityOn() and board.height(move.col) != move.row)) {
+            record.result = loser;
+            record.end = "illegal";
+            return record;
+        }
+        board.place(board.cell(move.col, move.row), piece);
+        record.moves++;
+        if (board.hasWin(piece)) {
+            record.result = -loser;
+            record.end = "line";
+            return record;
+        }
+        lastMove = move;
+        piece = -piece;
+    }
+    return record;
+}
+
+void addStats(SideStats &total, const SideStats &stats) {
+    total.moves += stats.moves;
+    total.reported += stats.reported;
+    total.nodes += stats.nodes;
+    total.searched += stats.searched;
+    total.depths += stats.depths;
+    total.savedMs += stats.savedMs;
+    total.wastedMs += stats.wastedMs;
+    total.timeMs += stats.timeMs;
+}
+
+void writeGame(ostream &out, int index, const GameRecord &game) {
+    out << index << '\t' << game.opening << '\t'
+        << (game.engineFirst ? "engine" : "opponent") << '\t'
+        << (game.result > 0 ? "win" : game.result < 0 ? "loss" : "draw")
+        << '\t' << game.moves << '\t' << game.end << endl;
+}
+
+string formatElo(double elo) {
+    if (isinf(elo)) {
+        return elo > 0 ? "+inf" : "-inf";
+    }
+    ostringstream text;
+    text << showpos << fixed << setprecision(1) << elo;
+    return text.str();
+}
+
+void writeSide(ostream &out, const string &name, const SideStats &stats) {
+    out << name << ": " << stats.moves << " moves";
+    if (stats.moves == 0) {
+        out << endl;
+        return;
+    }
+    out << fixed << setprecision(1);
+    if (stats.searched > 0) {
+        out << ", depth " << double(stats.depths) / stats.searched << ", "
+            << double(stats.savedMs) / stats.searched << " ms saved, "
+            << double(stats.wastedMs) / stats.searched << " ms wasted";
+    }
+    if (stats.reported > 0) {
+        out << ", " << stats.nodes / stats.reported << " nodes";
+    }
+    out << ", " << double(stats.timeMs) / stats.moves << " ms per move"
+        << endl;
+    out.unsetf(ios::floatfield);
+}
+} // namespace
+
+double eloDifference(double score) {
+    if (score <= 0) {
+        return -INFINITY;
+    }
+    if (score >= 1) {
+        return INFINITY;
+    }
+    return 400 * log10(score / (1 - score));
+}
+
+double MatchResult::score() const {
+    return played() ? (wins + 0.5 * draws) / played() : 0.5;
+}
+
+double MatchResult::elo() const {
+    return eloDifference(score());
+}
+
+double MatchResult::eloError() const {
+    if (wins + draws == 0 or losses + draws == 0) {
+        return INFINITY;
+    }
+    // Standard error of the mean score of a game.
+    const int n = played();
+    const double p = score();
+    const double variance = (wins * (1 - p) * (1 - p) +
+                             draws * (0.5 - p) * (0.5 - p) + losses * p * p) /
+                            n;
+    const double error = Z_95 * sqrt(variance / n);
+    return (eloDifference(p + error) - eloDifference(p - error)) / 2;
+}
+
+bool readOpenings(istream &in, vector<MatchOpening> &openings,
+                  string &error) {
+    string line;
+    for (int lineNumber = 1; getline(in, line); lineNumber++) {
+        const size_t start = line.find_first_not_of(" \t\r");
+        if (start == string::npos or line[start] == '#') {
+            continue;
+        }
+        istringstream fields(line);
+        MatchOpening opening;
+        int gravity;
+        if (!(fields >> gravity >> opening.rules.numCols >>
+              opening.rules.numRows >> opening.rules.k)) {
+            error = "line " + to_string(lineNumber) + ": bad header";
+            return false;
+        }
+        opening.rules.gravityOn = gravity != 0;
+        int col, row;
+        bool paired = true;
+        while (paired and fields >> col) {
+            paired = bool(fields >> row);
+            opening.moves.push_back(Move(col, row));
+        }
+        string problem;
+        if (!paired or !fields.eof()) {
+            problem = "moves must be pairs of numbers";
+        } else {
+            problem = checkRules(opening.rules);
+        }
+        if (problem.empty()) {
+            Board board(opening.rules.gravityOn, opening.rules.numCols,
+                        opening.rules.numRows, opening.rules.k);
+            problem = playOpening(opening, board);
+        }
+        if (!problem.empty()) {
+            error = "line " + to_string(lineNumber) + ": " + problem;
+            return false;
+        }
+        openings.push_back(opening);
+    }
+    return true;
+}
+
+vector<MatchOpening> randomOpenings(const vector<MatchRules> &rules,
+                                    int count, int plies, unsigned seed) {
+    vector<MatchOpening> openings;
+    mt19937 random(seed);
+    for (int i = 0; i < count and !rules.empty(); i++) {
+        MatchOpening opening;
+        opening.rules = rules[i % rules.size()];
+        Board board(opening.rules.gravityOn, opening.rules.numCols,
+                    opening.rules.numRows, opening.rules.k);
+        vector<int> moves;
+        int piece = AIShell::PLAYER_PIECE;
+        // Stops short of filling the board, and of a move that would win.
+        for (int ply = 0; ply < plies and board.numPieces() + 1 <
+                                              board.numCells();
+             ply++) {
+            moves.clear();
+            for (int cell = 0; cell < board.numCells(); cell++) {
+                if (board.isEmpty(cell) and
+                    (!board.gravityOn() or
+                     board.height(board.colOf(cell)) ==
+                         board.rowOf(cell))) {
+                    moves.push_back(cell);
+                }
+            }
+            shuffle(moves.begin(), moves.end(), random);
+            int played = -1;
+            for (int cell : moves) {
+                board.place(cell, piece);
+                if (!board.hasWin(piece)) {
+                    played = cell;
+                    break;
+                }
+                board.remove(cell, piece);
+            }
+            if (played < 0) {
+                break;
+            }
+            opening.moves.push_back(
+                Move(board.colOf(played), board.rowOf(played)));
+            piece = -piece;
+        }
+        openings.push_back(opening);
+    }
+    return openings;
+}
+
+MatchResult runMatch(const MatchPlayer &engine, const MatchPlayer &opponent,
+                     const vector<MatchOpening> &openings,
+                     const MatchSettings &settings, ostream *out) {
+    MatchResult result;
+    if (openings.empty()) {
+        return result;
+    }
+    const int games = (max(settings.games, 0) + 1) / 2 * 2;
+    const int deadline =
+        settings.moveTimeMs > 0 ? settings.moveTimeMs : NO_TIME_LIMIT;
+    if (!engine.command.empty() or !opponent.command.empty()) {
+        // A program that dies must not take the match down with it.
+        signal(SIGPIPE, SIG_IGN);
+    }
+    result.games.resize(games);
+    vector<bool> done(games, false);
+    atomic<int> next{0};
+    mutex lock; // guards result, done and written
+    int written = 0;
+
+    // Game 2i and 2i + 1 play the same opening, the engine first in the
+    // first of them.
+    auto work = [&] {
+        const unique_ptr<Player> engineSide = makePlayer(engine);
+        const unique_ptr<Player> opponentSide = makePlayer(opponent);
+        Player *const players[2] = {engineSide.get(), opponentSide.get()};
+        SideStats stats[2];
+        for (int g = next++; g < games; g = next++) {
+            const int opening = g / 2 % openings.size();
+            GameRecord record = playGame(players, openings[opening],
+                                         g % 2 == 0, deadline, stats);
+            record.opening = opening;
+
+            lock_guard<mutex> guard(lock);
+            result.games[g] = record;
+            done[g] = true;
+            for (; out and written < games and done[written]; written++) {
+                writeGame(*out, written, result.games[written]);
+            }
+        }
+        lock_guard<mutex> guard(lock);
+        addStats(result.engine, stats[0]);
+        addStats(result.opponent, stats[1]);
+    };
+
+    vector<thread> threads;
+    for (int w = 1; w < min(settings.workers, games); w++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &worker : threads) {
+        worker.join();
+    }
+
+    for (const GameRecord &game : result.games) {
+        result.wins += game.result > 0;
+        result.draws += game.result == 0;
+        result.losses += game.result < 0;
+    }
+    return result;
+}
+
+void writeMatchSummary(ostream &out, const MatchPlayer &engine,
+                       const MatchPlayer &opponent,
+                       const MatchResult &result) {
+    out << engine.name << " vs " << opponent.name << ": " << result.played()
+        << " games, +" << result.wins << " =" << result.draws << " -"
+        << result.losses << ", score " << fixed << setprecision(1)
+        << 100 * result.score() << "%" << endl;
+    out.unsetf(ios::floatfield);
+    const double error = result.eloError();
+    out << "Elo difference: " << formatElo(result.elo()) << " +/- "
+        << (isinf(error) ? "inf" : formatElo(error).substr(1)) << " (95%)"
+        << endl;
+    writeSide(out, engine.name, result.engine);
+    writeSide(out, opponent.name, result.opponent);
+}
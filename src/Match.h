@@ -0,0 +1,124 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "AIShell.h"
+#include "SearchOptions.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Engine against engine games, to check that a change makes the engine
+// stronger and not only faster.
+//
+// The engine and its opponent play every opening twice, each side moving
+// first once, so that an opening that favours one side is fair to both.
+// A player is either an AIShell of this build with its own options or
+// another program speaking the Java shell's protocol on its standard input
+// and output, so that one build can play another. Games are shared out
+// between worker threads, each with its own pair of players.
+//
+// Openings are read from lines of
+//
+//     gravity cols rows k col row col row...
+//
+// giving the rules and the moves played so far, first player first, or are
+// made of random moves. A game is lost by a player that makes a line of k
+// last, gives no move or an illegal one, or answers more than a grace period
+// after the deadline, and drawn when the board fills up. A program that
+// does not answer in time is stopped and started again for the next game.
+
+struct MatchRules {
+    bool gravityOn = true;
+    int numCols = 7;
+    int numRows = 6;
+    int k = 4;
+};
+
+struct MatchOpening {
+    MatchRules rules;
+    std::vector<Move> moves;
+};
+
+struct MatchPlayer {
+    std::string name;
+    SearchOptions options; // of the AIShell playing, if command is empty
+    std::string command;   // run by /bin/sh, speaking the shell protocol
+};
+
+struct MatchSettings {
+    int games = 100;     // played in pairs, so rounded up to an even number
+    int moveTimeMs = 100; // deadline of every move; 0 leaves the depth limits
+    int workers = 1;
+};
+
+struct GameRecord {
+    int opening = 0;
+    bool engineFirst = true;
+    int result = 0; // 1 if the engine won, -1 if it lost, 0 for a draw
+    int moves = 0;  // after the opening
+    // "line", "full", "illegal", "no move" or "time"
+    const char *end = "full";
+};
+
+// What one side did over the match. Players run as programs give no depth
+// or nodes.
+struct SideStats {
+    long long moves = 0;
+    long long reported = 0; // moves with a count of nodes
+    long long nodes = 0;    // summed over the moves reported
+    long long searched = 0; // moves found by the alpha-beta search
+    long long depths = 0;   // summed over the moves searched
+    long long savedMs = 0;  // of the budget, summed over the moves searched
+    long long wastedMs = 0; // on unfinished iterations, likewise
+    long long timeMs = 0;
+};
+
+struct MatchResult {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    SideStats engine;
+    SideStats opponent;
+    std::vector<GameRecord> games;
+
+    int played() const { return wins + draws + losses; }
+    // Share of the points won by the engine, a draw counting half.
+    double score() const;
+    // Elo rating of the engine minus the opponent's implied by the score,
+    // and the half width of its 95% confidence interval. Either is infinite
+    // when a side scored nothing.
+    double elo() const;
+    double eloError() const;
+};
+
+// Elo difference of a player that wins score of the points.
+double eloDifference(double score);
+
+// Reads every opening of in. On a malformed or finished opening returns
+// false with error saying which line and why.
+bool readOpenings(std::istream &in, std::vector<MatchOpening> &openings,
+                  std::string &error);
+
+// count openings of plies random moves, taking the rules in turn; the same
+// seed gives the same openings.
+std::vector<MatchOpening> randomOpenings(const std::vector<MatchRules> &rules,
+                                         int count, int plies,
+                                         unsigned seed);
+
+// Plays settings.games games of engine against opponent from openings in
+// turn. Each game is written to out, if given, as soon as those before it
+// are, as tab-separated fields:
+//
+//     game opening first result moves end
+//
+// where first is "engine" or "opponent" and result is "win", "draw" or
+// "loss" for the engine.
+MatchResult runMatch(const MatchPlayer &engine, const MatchPlayer &opponent,
+                     const std::vector<MatchOpening> &openings,
+                     const MatchSettings &settings,
+                     std::ostream *out = nullptr);
+
+void writeMatchSummary(std::ostream &out, const MatchPlayer &engine,
+                       const MatchPlayer &opponent, const MatchResult &result);
+
+#endif // MATCH_H
@@ -0,0 +1,560 @@
+#include "MonteCarlo.h"
+#include "AIShell.h"
+#include "BoardShape.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace {
+static const bool DEBUG = false;
+
+// A leaf gets its children on this visit, so that most playouts from the
+// edge of the tree do not cost a node per move.
+static const int EXPAND_VISITS = 4;
+
+// Weight of the exploration term of UCT against the mean result in [0, 1].
+static const float EXPLORATION = 0.7f;
+
+// Without gravity, only cells at most this far from a piece (in kings'
+// moves) become children in the tree, and a random move of a playout is
+// drawn up to NEAR_TRIES times until it lands next to a piece.
+static const int CHILD_DISTANCE = 2;
+static const int NEAR_TRIES = 4;
+
+// Playouts between reads of the clock.
+static const int POLL_PLAYOUTS = 64;
+
+// Steps from a cell to the next one of a line: {column, row}.
+static const int DIRECTIONS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+// xorshift64*: the playouts need speed, not quality.
+inline uint32_t nextRandom(uint64_t &seed) {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return uint32_t((seed * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+inline int randomBelow(uint64_t &seed, int bound) {
+    return int((uint64_t(nextRandom(seed)) * uint32_t(bound)) >> 32);
+}
+
+inline int lowestCell(uint64_t cells) { return __builtin_ctzll(cells); }
+} // namespace
+
+MonteCarlo::Worker::Worker(const Board &board, uint64_t seed)
+    : board{board}, seed{seed}, moves(board.numCells()),
+      slot(board.numCells()), distances(board.numCells()) {
+    path.reserve(board.numCells() + 1);
+}
+
+MonteCarlo::MonteCarlo(const Board &board, const SearchOptions &options,
+                       SearchControl &control)
+    : options{options}, control{control}, root{board} {
+    const long long bytes = (long long)std::max(options.mctsMb, 1) << 20;
+    capacity = int(std::min<long long>(bytes / 2 / sizeof(Node), INT32_MAX));
+    capacity = std::max(capacity, board.numCells() + 1);
+    pools[0].reset(new Node[capacity]);
+    pools[1].reset(new Node[capacity]);
+    for (int i = 0; i < options.threads; i++) {
+        workers.emplace_back(board, 0x9E3779B97F4A7C15ULL * (i + 1));
+    }
+    if (board.isShape<Connect4>()) {
+        playoutKernel = &MonteCarlo::shapePlayout<Connect4>;
+    } else if (board.isShape<Gravity9x7>()) {
+        playoutKernel = &MonteCarlo::shapePlayout<Gravity9x7>;
+    } else if (board.isShape<Open9x7>()) {
+        playoutKernel = &MonteCarlo::shapePlayout<Open9x7>;
+    } else {
+        playoutKernel = &MonteCarlo::playout;
+    }
+}
+
+inline bool MonteCarlo::playable(const Board &board, int cell) const {
+    return board.isEmpty(cell) and
+           (!board.gravityOn() or
+            board.height(board.colOf(cell)) == board.rowOf(cell));
+}
+
+// Pieces of piece in a row from (col, row) on, the cell itself left out,
+// going dir[0] columns and dir[1] rows a step.
+int MonteCarlo::runLength(const Board &board, int col, int row,
+                          const int *dir, int sign, int piece) const {
+    int run = 0;
+    col += sign * dir[0];
+    row += sign * dir[1];
+    while (col >= 0 and col < board.numCols() and row >= 0 and
+           row < board.numRows() and board.pieceAt(col, row) == piece) {
+        run++;
+        col += sign * dir[0];
+        row += sign * dir[1];
+    }
+    return run;
+}
+
+// Whether piece played on cell makes k in a row. Only the runs through cell
+// can, so only they are counted.
+bool MonteCarlo::completesLine(const Board &board, int cell,
+                               int piece) const {
+    const int col = board.colOf(cell), row = board.rowOf(cell);
+    for (auto &dir : DIRECTIONS) {
+        if (1 + runLength(board, col, row, dir, -1, piece) +
+                runLength(board, col, row, dir, 1, piece) >=
+            board.k()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A playable cell where piece completes a line through from, its own earlier
+// move, or -1. Such a cell has to be the first free one at an end of the run
+// through from in the line's direction, and the line can only be that one.
+int MonteCarlo::winningCell(const Board &board, int from, int piece) const {
+    if (from < 0) {
+        return -1;
+    }
+    const int col = board.colOf(from), row = board.rowOf(from);
+    for (auto &dir : DIRECTIONS) {
+        const int ends[2] = {runLength(board, col, row, dir, -1, piece),
+                             runLength(board, col, row, dir, 1, piece)};
+        const int run = 1 + ends[0] + ends[1];
+        for (int end = 0; end < 2; end++) {
+            const int sign = end ? 1 : -1;
+            const int c = col + sign * (ends[end] + 1) * dir[0];
+            const int r = row + sign * (ends[end] + 1) * dir[1];
+            if (c < 0 or c >= board.numCols() or r < 0 or
+                r >= board.numRows()) {
+                continue;
+            }
+            const int cell = board.cell(c, r);
+            if (playable(board, cell) and
+                run + 1 + runLength(board, c, r, dir, sign, piece) >=
+                    board.k()) {
+                return cell;
+            }
+        }
+    }
+    return -1;
+}
+
+// Whether a piece is at most distance cells away from cell in kings' moves.
+bool MonteCarlo::nearPiece(const Board &board, int cell, int distance) const {
+    const int col = board.colOf(cell), row = board.rowOf(cell);
+    for (int c = std::max(col - distance, 0);
+         c <= std::min(col + distance, board.numCols() - 1); c++) {
+        for (int r = std::max(row - distance, 0);
+             r <= std::min(row + distance, board.numRows() - 1); r++) {
+            if (!board.isEmpty(c, r)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// How far a move to cell is from the pieces, from 1 to CHILD_DISTANCE, or one
+// more if it is farther, or 0 if it cannot be played. Every move counts as
+// near with gravity or on an empty board.
+int MonteCarlo::childDistance(const Board &board, int cell) const {
+    if (!playable(board, cell)) {
+        return 0;
+    } else if (board.gravityOn() or board.numPieces() == 0) {
+        return 1;
+    }
+    for (int distance = 1; distance <= CHILD_DISTANCE; distance++) {
+        if (nearPiece(board, cell, distance)) {
+            return distance;
+        }
+    }
+    return CHILD_DISTANCE + 1;
+}
+
+// Gives the node its children unless another thread is already at it or the
+// pool is full. Cells nearer the pieces come first, as the ones tried
+// first. Far cells are only children when there is no near one.
+bool MonteCarlo::expand(int index, Worker &worker) {
+    Node &node = pools[active][index];
+    int expected = LEAF;
+    if (!node.state.compare_exchange_strong(expected, EXPANDING)) {
+        return false;
+    }
+    const Board &board = worker.board;
+    int near = 0, far = 0;
+    for (int cell = 0; cell < board.numCells(); cell++) {
+        const int distance = childDistance(board, cell);
+        worker.distances[cell] = distance;
+        near += distance > 0 and distance <= CHILD_DISTANCE;
+        far += distance > CHILD_DISTANCE;
+    }
+    const int count = near ? near : far;
+    const int farthest = near ? CHILD_DISTANCE : CHILD_DISTANCE + 1;
+    int first = used.load();
+    do {
+        if (first + count > capacity) {
+            node.state = LEAF;
+            return false;
+        }
+    } while (!used.compare_exchange_weak(first, first + count));
+
+    Node *child = &pools[active][first];
+    for (int distance = 1; distance <= farthest; distance++) {
+        for (int cell = 0; cell < board.numCells(); cell++) {
+            if (worker.distances[cell] != distance) {
+                continue;
+            }
+            child->visits = 0;
+            child->score = 0;
+            child->state = LEAF;
+            child->firstChild = -1;
+            child->numChildren = 0;
+            child->move = cell;
+            child++;
+        }
+    }
+    node.firstChild = first;
+    node.numChildren = count;
+    node.state.store(EXPANDED, std::memory_order_release);
+    return true;
+}
+
+// The child with the best upper confidence bound, or the first one nobody
+// has visited yet.
+int MonteCarlo::select(const Node &node) const {
+    const Node *children = &pools[active][node.firstChild];
+    const float logVisits =
+        std::log(float(std::max(node.visits.load(std::memory_order_relaxed),
+                                1)));
+    int best = 0;
+    float bestValue = -1;
+    for (int i = 0; i < node.numChildren; i++) {
+        const int visits =
+            children[i].visits.load(std::memory_order_relaxed);
+        if (visits == 0) {
+            return node.firstChild + i;
+        }
+        const float value =
+            children[i].score.load(std::memory_order_relaxed) /
+                (2.0f * visits) +
+            EXPLORATION * std::sqrt(logVisits / visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = i;
+        }
+    }
+    return node.firstChild + best;
+}
+
+// Plays the game out from the worker's board, mover to move after last and
+// previous, and returns the winning piece, or 0 for a draw. With the light
+// policy a side completes a line of its own when it can and otherwise
+// blocks one the other side has just made a move from completing; all other
+// moves are random.
+int MonteCarlo::playout(Worker &worker, int mover, int last,
+                        int previous) const {
+    Board &board = worker.board;
+    const bool gravity = board.gravityOn();
+    int count = 0;
+    if (gravity) {
+        for (int col = 0; col < board.numCols(); col++) {
+            if (board.colHasSpace(col)) {
+                worker.slot[col] = count;
+                worker.moves[count++] = col;
+            }
+        }
+    } else {
+        for (int cell = 0; cell < board.numCells(); cell++) {
+            if (board.isEmpty(cell)) {
+                worker.slot[cell] = count;
+                worker.moves[count++] = cell;
+            }
+        }
+    }
+
+    while (count > 0) {
+        int cell = -1;
+        if (options.mctsLight) {
+            cell = winningCell(board, previous, mover);
+            if (cell < 0) {
+                cell = winningCell(board, last, -mover);
+            }
+        }
+        int index;
+        if (cell >= 0) {
+            index = worker.slot[gravity ? board.colOf(cell) : cell];
+        } else {
+            index = randomBelow(worker.seed, count);
+            for (int i = 1; i < NEAR_TRIES and !gravity and
+                            !nearPiece(board, worker.moves[index], 1);
+                 i++) {
+                index = randomBelow(worker.seed, count);
+            }
+            const int move = worker.moves[index];
+            cell = gravity ? board.cell(move, board.height(move)) : move;
+        }
+        if (completesLine(board, cell, mover)) {
+            return mover;
+        }
+        board.place(cell, mover);
+        if (!gravity or !board.colHasSpace(board.colOf(cell))) {
+            const int moved = worker.moves[--count];
+            worker.moves[index] = moved;
+            worker.slot[moved] = index;
+        }
+        previous = last;
+        last = cell;
+        mover = -mover;
+    }
+    return 0;
+}
+
+// playout on one word per side and constant bounds. The light policy looks
+// at every line on the board rather than only those through the last two
+// moves, so it takes and blocks any win there is, and needs no last moves.
+template <class Shape>
+int MonteCarlo::shapePlayout(Worker &worker, int mover, int, int) const {
+    const Shape &shape = Shape::get();
+    const Board &board = worker.board;
+    const bool gravity = Shape::gravityOn();
+    uint64_t own = board.mask(mover)[0];
+    uint64_t other = board.mask(-mover)[0];
+    uint64_t playable = 0;
+    int heights[Shape::numCols()];
+    int count = 0;
+    for (int col = 0; col < Shape::numCols(); col++) {
+        heights[col] = board.height(col);
+        if (gravity and heights[col] < Shape::numRows()) {
+            playable |= Shape::bit(Shape::cell(col, heights[col]));
+            worker.slot[col] = count;
+            worker.moves[count++] = col;
+        }
+    }
+    if (!gravity) {
+        for (int cell = 0; cell < Shape::numCells(); cell++) {
+            if (!((own | other) & Shape::bit(cell))) {
+                playable |= Shape::bit(cell);
+                worker.slot[cell] = count;
+                worker.moves[count++] = cell;
+            }
+        }
+    }
+
+    while (count > 0) {
+        int cell = -1;
+        if (options.mctsLight) {
+            if (shape.winningCells(own) & playable) {
+                return mover;
+            }
+            const uint64_t blocks = shape.winningCells(other) & playable;
+            if (blocks) {
+                cell = lowestCell(blocks);
+            }
+        }
+        int index;
+        if (cell >= 0) {
+            index = worker.slot[gravity ? Shape::colOf(cell) : cell];
+        } else {
+            index = randomBelow(worker.seed, count);
+            for (int i = 1; i < NEAR_TRIES and !gravity and
+                            !(shape.neighboursOf(worker.moves[index]) &
+                              (own | other));
+                 i++) {
+                index = randomBelow(worker.seed, count);
+            }
+            const int move = worker.moves[index];
+            cell = gravity ? Shape::cell(move, heights[move]) : move;
+        }
+        // The light policy has already found any win of the mover.
+        own |= Shape::bit(cell);
+        if (!options.mctsLight and shape.hasLine(own)) {
+            return mover;
+        }
+        playable &= ~Shape::bit(cell);
+        const int col = Shape::colOf(cell);
+        if (gravity and ++heights[col] < Shape::numRows()) {
+            playable |= Shape::bit(cell + 1);
+        } else {
+            const int moved = worker.moves[--count];
+            worker.moves[index] = moved;
+            worker.slot[moved] = index;
+        }
+        std::swap(own, other);
+        mover = -mover;
+    }
+    return 0;
+}
+
+// One iteration: down the tree to a leaf, a playout from there, and its
+// result back up the path.
+void MonteCarlo::iterate(Worker &worker) {
+    Board &board = worker.board;
+    board = root;
+    worker.path.clear();
+    worker.path.push_back(0);
+    Node *pool = pools[active].get();
+    pool[0].visits.fetch_add(1, std::memory_order_relaxed);
+
+    int mover = AIShell::PLAYER_PIECE;
+    int last = rootLast, previous = rootPrevious;
+    int index = 0;
+    int winner = 0;
+    bool over = false;
+    while (true) {
+        Node &node = pool[index];
+        if (node.state.load(std::memory_order_acquire) != EXPANDED and
+            (node.visits.load(std::memory_order_relaxed) < EXPAND_VISITS or
+             !expand(index, worker))) {
+            break;
+        }
+        index = select(node);
+        Node &child = pool[index];
+        child.visits.fetch_add(1, std::memory_order_relaxed);
+        worker.path.push_back(index);
+        over = completesLine(board, child.move, mover);
+        board.place(child.move, mover);
+        previous = last;
+        last = child.move;
+        if (over) {
+            winner = mover;
+            break;
+        } else if (board.numPieces() == board.numCells()) {
+            over = true;
+            break;
+        }
+        mover = -mover;
+    }
+    if (!over) {
+        winner = (this->*playoutKernel)(worker, mover, last, previous);
+    }
+
+    // The player moved into the nodes at odd depths.
+    for (int depth = 1; depth < int(worker.path.size()); depth++) {
+        const int side = (depth % 2) ? AIShell::PLAYER_PIECE
+                                     : AIShell::OPPONENT_PIECE;
+        const int points = winner == side ? 2 : winner == 0 ? 1 : 0;
+        pool[worker.path[depth]].score.fetch_add(points,
+                                                 std::memory_order_relaxed);
+    }
+    worker.playouts++;
+}
+
+void MonteCarlo::work(Worker &worker) {
+    worker.playouts = 0;
+    while (!control.outOfTime) {
+        iterate(worker);
+        if (worker.playouts % POLL_PLAYOUTS == 0 and
+            control.time.hardExpired(Clock::now())) {
+            control.outOfTime = true;
+        }
+    }
+}
+
+int MonteCarlo::search() {
+    workers[0].board = root;
+    if (pools[active][0].state != EXPANDED and !expand(0, workers[0])) {
+        // Only a pool filled up by the tree kept from earlier moves.
+        reset();
+        expand(0, workers[0]);
+    }
+    Node &top = pools[active][0];
+    // A move that wins at once needs no search, and neither does the only
+    // move there is.
+    for (int i = 0; i < top.numChildren; i++) {
+        const int cell = pools[active][top.firstChild + i].move;
+        if (top.numChildren == 1 or
+            completesLine(root, cell, AIShell::PLAYER_PIECE)) {
+            playouts = 0;
+            return cell;
+        }
+    }
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < int(workers.size()); i++) {
+        Worker *worker = &workers[i];
+        helpers.emplace_back([this, worker] { work(*worker); });
+    }
+    work(workers[0]);
+    control.outOfTime = true;
+    for (auto &helper : helpers) {
+        helper.join();
+    }
+
+    playouts = 0;
+    for (auto &worker : workers) {
+        playouts += worker.playouts;
+    }
+    int best = top.firstChild;
+    for (int i = 0; i < top.numChildren; i++) {
+        const Node &child = pools[active][top.firstChild + i];
+        if (child.visits > pools[active][best].visits) {
+            best = top.firstChild + i;
+        }
+    }
+    if (DEBUG) {
+        const Node &child = pools[active][best];
+        std::cout << "MCTS: cell " << child.move << ", " << child.visits
+                  << " of " << top.visits << " visits, mean "
+                  << child.score / (2.0 * std::max(child.visits.load(), 1))
+                  << "." << std::endl;
+    }
+    return pools[active][best].move;
+}
+
+void MonteCarlo::reset() {
+    Node &top = pools[active][0];
+    top.visits = 0;
+    top.score = 0;
+    top.state = LEAF;
+    top.firstChild = -1;
+    top.numChildren = 0;
+    used = 1;
+}
+
+// Copies the subtree under index to the front of the other pool, breadth
+// first, and makes that the tree. Until a copied node is reached in the
+// copy, its firstChild holds its index in the old pool.
+void MonteCarlo::keepSubtree(int index) {
+    const Node *from = pools[active].get();
+    Node *to = pools[1 - active].get();
+    int size = 1;
+    for (int i = 0; i < size; i++) {
+        const Node &old = from[i == 0 ? index : to[i].firstChild];
+        Node &copy = to[i];
+        copy.visits = old.visits.load();
+        copy.score = old.score.load();
+        copy.move = old.move;
+        if (old.state != EXPANDED) {
+            copy.state = LEAF;
+            copy.firstChild = -1;
+            copy.numChildren = 0;
+            continue;
+        }
+        copy.state = EXPANDED;
+        copy.firstChild = size;
+        copy.numChildren = old.numChildren;
+        for (int j = 0; j < old.numChildren; j++) {
+            to[size++].firstChild = old.firstChild + j;
+        }
+    }
+    active = 1 - active;
+    used = size;
+}
+
+void MonteCarlo::playMove(int cell, int piece) {
+    root.place(cell, piece);
+    rootPrevious = rootLast;
+    rootLast = cell;
+    const Node &top = pools[active][0];
+    if (top.state == EXPANDED) {
+        for (int i = 0; i < top.numChildren; i++) {
+            if (pools[active][top.firstChild + i].move == cell) {
+                keepSubtree(top.firstChild + i);
+                return;
+            }
+        }
+    }
+    reset();
+}
+
+int MonteCarlo::rootVisits() const { return pools[active][0].visits; }
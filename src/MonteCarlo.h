@@ -0,0 +1,99 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include "Board.h"
+#include "SearchOptions.h"
+#include "Searcher.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Monte Carlo Tree Search, the engine for large boards without gravity,
+// whose game trees alpha-beta gets only a few plies into.
+//
+// Every iteration walks down the tree by UCT, gives the node it stops at its
+// children once it has been visited often enough, plays the game out from
+// there and counts the result in every node on the way. Threads share the
+// tree: one on its way down counts its visit at once, a virtual loss that
+// steers the others to other lines until its result is in. The nodes come
+// from a pool of fixed size. When a game move is played the subtree under it
+// is kept, copied to the front of a second pool, and the rest dropped.
+class MonteCarlo {
+    enum { LEAF, EXPANDING, EXPANDED };
+
+    struct Node {
+        std::atomic<int> visits{0};
+        std::atomic<int> score{0}; // half points of the side that moved here
+        std::atomic<int> state{LEAF};
+        int firstChild = -1;
+        int numChildren = 0;
+        int move = -1;
+    };
+
+    // What one thread needs for its iterations, allocated up front.
+    struct Worker {
+        Board board;
+        uint64_t seed;
+        std::vector<int> path;  // nodes from the root down
+        std::vector<int> moves; // cells (columns with gravity) still free
+        std::vector<int> slot;  // index of each cell or column in moves
+        std::vector<int> distances; // of each cell, for ordering children
+        long long playouts = 0;
+
+        Worker(const Board &board, uint64_t seed);
+    };
+
+    const SearchOptions &options;
+    SearchControl &control;
+    Board root;
+    // The last two moves played to reach the root, for the playout policy.
+    int rootLast = -1;
+    int rootPrevious = -1;
+    std::unique_ptr<Node[]> pools[2];
+    int active = 0; // pools[active] holds the tree, rooted at its node 0
+    int capacity;
+    std::atomic<int> used{1};
+    std::vector<Worker> workers;
+    // Plays the game out from a worker's board: playout, or on the common
+    // board shapes shapePlayout compiled for that shape.
+    typedef int (MonteCarlo::*Playout)(Worker &, int, int, int) const;
+    Playout playoutKernel;
+
+    bool playable(const Board &board, int cell) const;
+    int runLength(const Board &board, int col, int row, const int *dir,
+                  int sign, int piece) const;
+    bool completesLine(const Board &board, int cell, int piece) const;
+    int winningCell(const Board &board, int from, int piece) const;
+    bool nearPiece(const Board &board, int cell, int distance) const;
+    int childDistance(const Board &board, int cell) const;
+    bool expand(int index, Worker &worker);
+    int select(const Node &node) const;
+    int playout(Worker &worker, int mover, int last, int previous) const;
+    template <class Shape>
+    int shapePlayout(Worker &worker, int mover, int last, int previous) const;
+    void iterate(Worker &worker);
+    void work(Worker &worker);
+    void reset();
+    void keepSubtree(int index);
+
+  public:
+    long long playouts = 0; // games played out by the last search
+
+    // board is the position the tree starts from.
+    MonteCarlo(const Board &board, const SearchOptions &options,
+               SearchControl &control);
+
+    // Plays a move of the game on the root, keeping what the tree knows
+    // about the position it leads to.
+    void playMove(int cell, int piece);
+    // Searches the root, where AIShell::PLAYER_PIECE is to move, with
+    // options.threads threads until control says to stop. Returns the cell
+    // of the most visited move.
+    int search();
+
+    int treeSize() const { return used.load(); }
+    int rootVisits() const;
+};
+
+#endif // MONTECARLO_H
@@ -11,7 +11,7 @@ bool Move::operator==(const Move &other) const {
     return this->row == other.row and this->col == other.col;
 }
 
-bool Move::operator!=(const Move &other) const { return !(this == &other); }
+bool Move::operator!=(const Move &other) const { return !(*this == other); }
 
 std::ostream &operator<<(std::ostream &strm, const Move &move) {
     return strm << "Move(" << move.col << ", " << move.row << ")";
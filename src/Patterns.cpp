@@ -0,0 +1,103 @@
+#include "Patterns.h"
+#include "AIShell.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+namespace {
+// Worth of k - 1 pieces in a window, against 1 for an empty one.
+static const int FOUR_SCORE = 8;
+
+// The pieces of the first length cells of a line from their code.
+void decode(uint32_t code, int length, int *cells) {
+    const int pieces[3] = {AIShell::NO_PIECE, AIShell::PLAYER_PIECE,
+                           AIShell::OPPONENT_PIECE};
+    for (int i = 0; i < length; i++, code /= 3) {
+        cells[i] = pieces[code % 3];
+    }
+}
+
+// Pieces of each side in the first length cells of a decoded line.
+void countPieces(const int *cells, int length, int &player, int &opponent) {
+    player = opponent = 0;
+    for (int i = 0; i < length; i++) {
+        player += cells[i] == AIShell::PLAYER_PIECE;
+        opponent += cells[i] == AIShell::OPPONENT_PIECE;
+    }
+}
+
+// Worth of a window holding pieces of one side only, by their number.
+int windowScore(int pieces, int k) {
+    const int shift = std::max(0, pieces - std::max(k - 4, 0));
+    return std::min(1 << shift, FOUR_SCORE);
+}
+
+// Whether cells, k + 1 of them, hold an open three for piece: k - 2 of its
+// pieces in a row, the end cells of the frame empty and nothing else in it.
+bool openThree(const int *cells, int k, int piece) {
+    if (k < 4 or cells[0] != AIShell::NO_PIECE or
+        cells[k] != AIShell::NO_PIECE) {
+        return false;
+    }
+    int first = -1, count = 0;
+    for (int i = 1; i < k; i++) {
+        if (cells[i] == -piece) {
+            return false;
+        } else if (cells[i] == piece) {
+            first = first < 0 ? i : first;
+            count++;
+        }
+    }
+    if (count != k - 2) {
+        return false;
+    }
+    for (int i = first; i < first + count; i++) {
+        if (cells[i] != piece) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+Patterns::Patterns(int k)
+    : windows(power(k)), frames(power(k + 1), 0) {
+    int cells[MAX_K + 1];
+    for (uint32_t code = 0; code < windows.size(); code++) {
+        decode(code, k, cells);
+        int player, opponent;
+        countPieces(cells, k, player, opponent);
+        Window &window = windows[code];
+        if (player and opponent) {
+            continue;
+        } else if (player < k and opponent < k) {
+            window.score = opponent ? -windowScore(opponent, k)
+                                    : player ? windowScore(player, k)
+                                             : 0;
+        }
+        if (k > 1 and player + opponent == k - 1) {
+            window.hole =
+                std::find(cells, cells + k, AIShell::NO_PIECE) - cells;
+            window.owner = player ? AIShell::PLAYER_PIECE
+                                  : AIShell::OPPONENT_PIECE;
+        }
+    }
+    for (uint32_t code = 0; code < frames.size(); code++) {
+        decode(code, k + 1, cells);
+        if (openThree(cells, k, AIShell::PLAYER_PIECE)) {
+            frames[code] = FOUR_SCORE;
+        } else if (openThree(cells, k, AIShell::OPPONENT_PIECE)) {
+            frames[code] = -FOUR_SCORE;
+        }
+    }
+}
+
+const Patterns &Patterns::forK(int k) {
+    static std::mutex mutex;
+    static std::unique_ptr<Patterns> tables[MAX_K + 1];
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!tables[k]) {
+        tables[k].reset(new Patterns(k));
+    }
+    return *tables[k];
+}
@@ -0,0 +1,55 @@
+#ifndef PATTERNS_H
+#define PATTERNS_H
+
+#include <cstdint>
+#include <vector>
+
+// Scores of the patterns a line can hold, for the pattern evaluator.
+//
+// A window of k cells, or a frame of k + 1 cells, is coded in base 3: cell i
+// adds 3^i for a piece of the player and 2 * 3^i for one of the opponent.
+// Each table maps a code straight to what the window adds to the score, so
+// the evaluator costs one load per window however elaborate the heuristic.
+// The scores follow the README's "Thinking ahead" list: a window one side
+// has to itself is worth more the more pieces it holds, roughly doubling
+// from k - 3 pieces to k - 1, and k - 2 pieces in a row with the cells at
+// both ends of their frame free (an open three) are worth as much as k - 1.
+// A window short of a single piece (a four) is also flagged with the cell
+// that would complete it, which the evaluator needs to spot traps.
+class Patterns {
+  public:
+    struct Window {
+        int16_t score = 0; // for the player, negative for the opponent
+        int8_t hole = -1;  // the cell a four lacks, or -1
+        int8_t owner = 0;  // the piece the four belongs to
+    };
+
+    // Longest line the tables are built for: 3^(MAX_K + 1) frame codes.
+    static const int MAX_K = 10;
+
+  private:
+    std::vector<Window> windows;   // by the code of a k-window
+    std::vector<int16_t> frames;   // by the code of a (k + 1)-frame
+
+    explicit Patterns(int k);
+
+  public:
+    // The tables for lines of k, built on first use and shared from then
+    // on. k must be between 1 and MAX_K.
+    static const Patterns &forK(int k);
+
+    static uint32_t power(int i) {
+        uint32_t p = 1;
+        while (i-- > 0) {
+            p *= 3;
+        }
+        return p;
+    }
+    // Digit of a piece in a code.
+    static uint32_t digit(int piece) { return piece > 0 ? 1 : 2; }
+
+    const Window &window(uint32_t code) const { return windows[code]; }
+    int frame(uint32_t code) const { return frames[code]; }
+};
+
+#endif // PATTERNS_H
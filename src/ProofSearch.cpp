@@ -0,0 +1,228 @@
+#include "ProofSearch.h"
+#include "AIShell.h"
+#include <algorithm>
+
+namespace {
+// The clock is read once every this many nodes.
+static const int POLL_NODES = 1024;
+
+// A proof number no amount of work brings down: the position is settled.
+static const uint32_t INF = 0x7FFFFFFF;
+
+// Sums of proof numbers stay finite unless one of the terms is infinite.
+inline uint32_t addNumbers(uint32_t a, uint32_t b) {
+    if (a == INF or b == INF) {
+        return INF;
+    }
+    return uint32_t(std::min<uint64_t>(uint64_t(a) + b, INF - 1));
+}
+} // namespace
+
+ProofSearch::ProofSearch(const Board &board, int hashSizeMb)
+    : board{board},
+      maxMoves{board.gravityOn() ? board.numCols() : board.numCells()},
+      moveStack{new int[(board.numCells() + 1) * maxMoves]} {
+    const uint64_t maxBuckets = uint64_t(std::max(hashSizeMb, 1)) * 1024 *
+                                1024 / (sizeof(Entry) * BUCKET_SIZE);
+    uint64_t buckets = 1;
+    while (buckets * 2 <= maxBuckets) {
+        buckets *= 2;
+    }
+    table.reset(new Entry[buckets * BUCKET_SIZE]);
+    bucketMask = buckets - 1;
+}
+
+inline const ProofSearch::Entry *ProofSearch::probe(uint64_t key) const {
+    const Entry *bucket = &table[(key & bucketMask) * BUCKET_SIZE];
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        if (bucket[i].key == key and bucket[i].search == search) {
+            return &bucket[i];
+        }
+    }
+    return nullptr;
+}
+
+// Replaces the same position, an entry left by an earlier search, or else
+// the entry that took the least work to find.
+void ProofSearch::store(uint64_t key, uint32_t phi, uint32_t delta,
+                        long long work, int move) {
+    Entry *bucket = &table[(key & bucketMask) * BUCKET_SIZE];
+    Entry *slot = &bucket[0];
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        Entry &entry = bucket[i];
+        if (entry.key == key or entry.search != search) {
+            slot = &entry;
+            break;
+        }
+        if (entry.work < slot->work) {
+            slot = &entry;
+        }
+    }
+    slot->key = key;
+    slot->phi = phi;
+    slot->delta = delta;
+    slot->work = uint32_t(std::min<long long>(work, UINT32_MAX));
+    slot->move = move;
+    slot->search = search;
+}
+
+int ProofSearch::generateMoves(int *moves) const {
+    int count = 0;
+    if (board.gravityOn()) {
+        for (int col = 0; col < board.numCols(); col++) {
+            if (board.colHasSpace(col)) {
+                moves[count++] = board.cell(col, board.height(col));
+            }
+        }
+    } else {
+        for (int cell = 0; cell < board.numCells(); cell++) {
+            if (board.isEmpty(cell)) {
+                moves[count++] = cell;
+            }
+        }
+    }
+    return count;
+}
+
+// The numbers of the position after mover plays cell, from the table if it
+// has them. A child that fills the board is a draw, which is as good as a
+// proof for the defender; any other new child counts as one leaf either way.
+void ProofSearch::childNumbers(int cell, int mover, uint32_t &phi,
+                               uint32_t &delta) const {
+    const int side = (mover == AIShell::PLAYER_PIECE) ? 0 : 1;
+    const Entry *entry = probe(board.hash() ^ Board::zobrist[side][cell]);
+    if (entry) {
+        phi = entry->phi;
+        delta = entry->delta;
+    } else if (board.numPieces() + 1 == board.numCells()) {
+        const bool attacking = -mover == attacker;
+        phi = attacking ? INF : 0;
+        delta = attacking ? 0 : INF;
+    } else {
+        phi = delta = 1;
+    }
+}
+
+// Expands the current node until its phi or delta reaches the threshold set
+// for it. The side to move is the player at even plies.
+void ProofSearch::mid(int ply, uint32_t thPhi, uint32_t thDelta) {
+    if (++nodes % POLL_NODES == 0 and Clock::now() >= stopAt) {
+        stopped = true;
+    }
+    if (stopped) {
+        return;
+    }
+    const int mover =
+        (ply % 2 == 0) ? AIShell::PLAYER_PIECE : AIShell::OPPONENT_PIECE;
+    const uint64_t key = board.hash();
+    const long long nodesBefore = nodes;
+    int *moves = &moveStack[ply * maxMoves];
+    const int count = generateMoves(moves);
+
+    // A move that completes a line settles the node.
+    for (int i = 0; i < count; i++) {
+        board.place(moves[i], mover);
+        const bool won = board.hasWin(mover);
+        board.remove(moves[i], mover);
+        if (won) {
+            store(key, 0, INF, 1, moves[i]);
+            return;
+        }
+    }
+
+    if (count == 0) {
+        const bool attacking = mover == attacker;
+        store(key, attacking ? INF : 0, attacking ? 0 : INF, 1, -1);
+        return;
+    }
+
+    uint32_t phi, delta;
+    int best = 0;
+    while (true) {
+        // phi is the cheapest child delta and delta the sum of child phis.
+        phi = INF;
+        delta = 0;
+        uint32_t bestPhi = 0, secondDelta = INF;
+        for (int i = 0; i < count; i++) {
+            uint32_t childPhi, childDelta;
+            childNumbers(moves[i], mover, childPhi, childDelta);
+            delta = addNumbers(delta, childPhi);
+            if (childDelta < phi) {
+                secondDelta = phi;
+                phi = childDelta;
+                bestPhi = childPhi;
+                best = i;
+            } else if (childDelta < secondDelta) {
+                secondDelta = childDelta;
+            }
+        }
+        if (phi >= thPhi or delta >= thDelta or stopped) {
+            break;
+        }
+        const uint32_t childThPhi = thDelta - delta + bestPhi;
+        const uint32_t childThDelta =
+            std::min(thPhi, secondDelta == INF ? INF : secondDelta + 1);
+        board.place(moves[best], mover);
+        mid(ply + 1, childThPhi, childThDelta);
+        board.remove(moves[best], mover);
+    }
+    if (!stopped) {
+        store(key, phi, delta, nodes - nodesBefore, moves[best]);
+    }
+}
+
+// Runs one search with piece as the attacker. Returns whether it settled
+// the root, with proved set to whether the player to move there got what it
+// wanted and move to the child that did it.
+bool ProofSearch::prove(int piece, bool &proved, int &move) {
+    attacker = piece;
+    if (++search == 0) {
+        for (uint64_t i = 0; i < (bucketMask + 1) * BUCKET_SIZE; i++) {
+            table[i] = Entry();
+        }
+        search = 1;
+    }
+    mid(0, INF, INF);
+    const Entry *root = probe(board.hash());
+    if (stopped or !root or (root->phi != 0 and root->delta != 0)) {
+        return false;
+    }
+    proved = root->phi == 0;
+    move = root->move;
+    return true;
+}
+
+ProofSearch::Result ProofSearch::solve(const Board &position,
+                                       Clock::time_point stopAt, int &move) {
+    board = position;
+    this->stopAt = stopAt;
+    nodes = 0;
+    stopped = false;
+
+    // First whether the player can win, and if not whether the opponent can.
+    bool proved;
+    if (!prove(AIShell::PLAYER_PIECE, proved, move)) {
+        return UNKNOWN;
+    } else if (proved) {
+        return WIN;
+    }
+    if (!prove(AIShell::OPPONENT_PIECE, proved, move)) {
+        return UNKNOWN;
+    } else if (proved) {
+        return DRAW;
+    }
+
+    // Every move loses. Play the one whose refutation took the most work.
+    int *moves = &moveStack[0];
+    const int count = generateMoves(moves);
+    const uint64_t key = board.hash();
+    uint32_t mostWork = 0;
+    for (int i = 0; i < count; i++) {
+        const Entry *entry = probe(key ^ Board::zobrist[0][moves[i]]);
+        if (entry and entry->work >= mostWork) {
+            mostWork = entry->work;
+            move = moves[i];
+        }
+    }
+    return LOSS;
+}
@@ -0,0 +1,69 @@
+#ifndef PROOFSEARCH_H
+#define PROOFSEARCH_H
+
+#include "Board.h"
+#include "TimeManager.h"
+#include <cstdint>
+#include <memory>
+
+// Depth-first proof-number search (df-pn), which solves a position outright
+// instead of scoring it.
+//
+// One search proves or disproves that a chosen side, the attacker, can force
+// a win. Every node keeps two numbers from the point of view of the side to
+// move: phi, the least number of leaves still to be solved to show that side
+// gets what it wants (a win for the attacker, no win for it for the
+// defender), and delta, the same for the opposite. The search always expands
+// the child that would most cheaply settle its parent, and backs up as soon
+// as a node's numbers pass the thresholds its parent set, so it needs no
+// more memory than its table: results that fall out of the table are simply
+// worked out again.
+class ProofSearch {
+  public:
+    // Game-theoretic value for the side to move.
+    enum Result { UNKNOWN, WIN, LOSS, DRAW };
+
+  private:
+    struct Entry {
+        uint64_t key = 0;
+        uint32_t phi = 0;
+        uint32_t delta = 0;
+        uint32_t work = 0;      // nodes spent on it, to pick what to replace
+        int16_t move = -1;      // child that settles it, or the cheapest one
+        uint16_t search = 0;    // which search stored it
+    };
+    static const int BUCKET_SIZE = 4;
+
+    std::unique_ptr<Entry[]> table;
+    uint64_t bucketMask = 0;
+    uint16_t search = 0;
+    Board board;
+    int attacker = 0;
+    // Moves of the node at each ply: ply p owns moveStack[p * maxMoves] on.
+    const int maxMoves;
+    std::unique_ptr<int[]> moveStack;
+    Clock::time_point stopAt;
+    bool stopped = false;
+
+    const Entry *probe(uint64_t key) const;
+    void store(uint64_t key, uint32_t phi, uint32_t delta, long long work,
+               int move);
+    int generateMoves(int *moves) const;
+    void childNumbers(int cell, int mover, uint32_t &phi,
+                      uint32_t &delta) const;
+    void mid(int ply, uint32_t thPhi, uint32_t thDelta);
+    bool prove(int piece, bool &proved, int &move);
+
+  public:
+    long long nodes = 0; // positions expanded by the last solve
+
+    // board gives the shape of the positions to be solved. hashSizeMb
+    // bounds the table, rounded down to a power-of-two number of buckets.
+    ProofSearch(const Board &board, int hashSizeMb);
+
+    // Solves a position for the side of AIShell::PLAYER_PIECE, to move,
+    // giving up at stopAt. move is set to a move that achieves the result.
+    Result solve(const Board &position, Clock::time_point stopAt, int &move);
+};
+
+#endif // PROOFSEARCH_H
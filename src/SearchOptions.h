@@ -0,0 +1,56 @@
+#ifndef SEARCHOPTIONS_H
+#define SEARCHOPTIONS_H
+
+// Tunable search settings, set from the command line in ConnectK.cpp.
+struct SearchOptions {
+    enum Algorithm {
+        ALPHA_BETA, // every child searched with the node's full window
+        PVS,        // later children scouted with a null window first
+        MTDF        // the root score narrowed down by null-window searches
+    };
+    enum Engine {
+        MINIMAX, // iterative deepening alpha-beta (Searcher)
+        MCTS,    // Monte Carlo Tree Search (MonteCarlo)
+        AUTO     // MCTS on large boards without gravity, minimax elsewhere
+    };
+
+    int hashSizeMb = 64;    // transposition table size; 0 disables it
+    bool symmetry = true;   // share table entries between mirrored positions
+    int maxDepth = 0;       // stop deepening after this depth; 0 for no limit
+    int threads = 1;        // search threads; more than 1 enables Lazy SMP
+    bool ybw = false;       // split the tree between threads (YBW) instead
+    int splitDepth = 3;     // shallowest remaining depth at which to split
+    bool ponder = false;    // search the expected reply on the opponent's time
+    int timeMarginMs = 50;  // kept back from each move's deadline
+    // How each iteration is searched.
+    Algorithm algorithm = PVS;
+    bool aspiration = true; // search each iteration around the last score
+    // Selective search on boards without gravity. Moves ordered after the
+    // first lmrMoves that neither make nor stop a threat are searched one ply
+    // shallower, and again at full depth if they beat the best so far. With
+    // pruneDepth plies or fewer left, cells more than pruneDistance away from
+    // every piece are not searched at all. 0 turns either off.
+    int lmrMoves = 4;       // children searched at full depth before reducing
+    int lmrDepth = 3;       // shallowest remaining depth at which to reduce
+    int pruneDepth = 2;     // deepest remaining depth at which to prune
+    int pruneDistance = 2;  // farthest a cell can be from a piece and be kept
+    // Threat-space search for forced wins, in moves of the attacker, before
+    // the root is searched; 0 turns it off. It can also be run on the leaves
+    // of the main search, looking for short wins by fours.
+    int threatDepth = 8;
+    bool threatLeaves = false;
+    // Score windows by the Patterns tables (partial lines, open threes and
+    // traps) instead of counting the possible wins.
+    bool patternEval = false;
+    // Positions with at most solveCells empty cells are first solved
+    // outright by proof-number search, in a table of solveHashMb.
+    int solveCells = 20;
+    int solveHashMb = 16;
+    // Which engine searches, and for MCTS the memory of its tree and whether
+    // its playouts take wins and block lines instead of playing at random.
+    Engine engine = MINIMAX;
+    int mctsMb = 64;
+    bool mctsLight = true;
+};
+
+#endif // SEARCHOPTIONS_H
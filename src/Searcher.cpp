@@ -0,0 +1,1092 @@
+#include "Searcher.h"
+#include "AIShell.h"
+#include "BoardShape.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+static const bool DEBUG = false;
+
+static const int NO_PIECE = AIShell::NO_PIECE;
+static const int PLAYER_PIECE = AIShell::PLAYER_PIECE;
+static const int OPPONENT_PIECE = AIShell::OPPONENT_PIECE;
+
+// Once the best root move has come out of this many iterations in a row,
+// the search stops by the soft deadline instead of the hard one.
+static const int STABLE_ITERATIONS = 4;
+
+// History scores are halved whenever one passes this, which keeps them well
+// below the scores of table and killer moves.
+static const int HISTORY_LIMIT = 1 << 24;
+
+// Half-width of the first aspiration window, doubled after every failure.
+static const int ASPIRATION_WINDOW = 4;
+
+// Most positions the threat search may visit at the root, and at each leaf
+// when it is used there (where it only looks for short wins by fours).
+static const long long ROOT_THREAT_NODES = 20000;
+static const int LEAF_THREAT_DEPTH = 4;
+static const long long LEAF_THREAT_NODES = 64;
+
+// Score of a trap at a leaf with the pattern evaluator, whose other scores
+// are kept below it.
+static const int TRAP_SCORE = Searcher::MAXWIN / 2;
+static const int PATTERN_LIMIT = TRAP_SCORE - 1;
+
+// Sorts items by descending score, keeping the order of items that tie.
+// The lists it sees are mostly in order already, and unlike std::stable_sort
+// it never allocates.
+template <typename T>
+inline void sortByScore(int *scores, T *items, const int count) {
+  for (int i = 1; i < count; i++) {
+    const int score = scores[i];
+    const T item = items[i];
+    int j = i;
+    for (; j > 0 and scores[j - 1] < score; j--) {
+      scores[j] = scores[j - 1];
+      items[j] = items[j - 1];
+    }
+    scores[j] = score;
+    items[j] = item;
+  }
+}
+
+std::random_device rd;
+} // namespace
+
+const int Searcher::MAXWIN;
+const int Searcher::MINWIN;
+
+Searcher::Searcher(const Board &board, const SearchOptions &options,
+                   TranspositionTable &tt, SearchControl &control,
+                   int threadIndex, ThreadPool *pool)
+    : gravityOn{board.gravityOn()}, numCols{board.numCols()},
+      numRows{board.numRows()}, k{board.k()}, threadIndex{threadIndex},
+      options{options}, tt{tt}, control{control}, board{board},
+      eval{board, options.patternEval}, frontier{board, options.pruneDistance},
+      threats{this->board, this->eval}, rng{rd()},
+      maxMoves{board.gravityOn() ? board.numCols() : board.numCells()},
+      moveStack{new int[(board.numCells() + 1) * maxMoves]},
+      pvTable{new int[board.numCells() * (board.numCells() + 1) / 2 + 1]},
+      pvLength{new int[board.numCells() + 1]()},
+      killers{new int[(board.numCells() + 1) * 2]},
+      history{new int[2 * board.numCells()]()},
+      orderScores{new int[board.numCells()]}, pool{pool} {
+  fill(killers.get(), killers.get() + (board.numCells() + 1) * 2, -1);
+  moves.reserve(board.numCells());
+  rootScores.reserve(board.numCells());
+  bestPv.reserve(board.numCells());
+  path.reserve(board.numCells());
+  lastMoves.reserve(board.numCells());
+  if (board.isShape<Connect4>()) {
+    boardPlace = &Board::placeShape<Connect4>;
+    boardRemove = &Board::removeShape<Connect4>;
+  } else if (board.isShape<Gravity9x7>()) {
+    boardPlace = &Board::placeShape<Gravity9x7>;
+    boardRemove = &Board::removeShape<Gravity9x7>;
+  } else if (board.isShape<Open9x7>()) {
+    boardPlace = &Board::placeShape<Open9x7>;
+    boardRemove = &Board::removeShape<Open9x7>;
+  } else {
+    boardPlace = &Board::place;
+    boardRemove = &Board::remove;
+  }
+  if (pool) {
+    splitPoints.reset(new SplitPoint[MAX_SPLITS]);
+    for (int i = 0; i < MAX_SPLITS; i++) {
+      splitPoints[i].path.reserve(board.numCells());
+      splitPoints[i].moves.reserve(board.numCells());
+      splitPoints[i].pv.reserve(board.numCells());
+    }
+  }
+}
+
+Searcher::~Searcher() {}
+
+inline void Searcher::checkTime() {
+  if (--untilPoll > 0) {
+    return;
+  }
+  const Clock::time_point now = Clock::now();
+  if (control.time.hardExpired(now)) {
+    control.outOfTime = true;
+  }
+  pollInterval = TimeManager::adaptPollInterval(pollInterval, now - lastPoll);
+  untilPoll = pollInterval;
+  lastPoll = now;
+}
+
+inline const Coord Searcher::dropPiece(const int col) const {
+  if (DEBUG and !board.colHasSpace(col)) {
+    cout << "dropPiece: Invalid column specified: index " << col << endl;
+    return {-1, -1}; // Make sure we never get here
+  }
+  return {col, board.height(col)};
+}
+
+inline bool Searcher::colHasSpace(const int col) const {
+  if (DEBUG and (col < 0 or col > (numCols - 1))) {
+    cout << "colHasSpace: Invalid column specified: index " << col << endl;
+  }
+  return board.colHasSpace(col);
+}
+
+inline bool Searcher::colNotEmpty(const int col) const {
+  return board.colNotEmpty(col);
+}
+
+// Appends move to moves unless seen, a bitboard of the cells already in
+// them, has it.
+inline void Searcher::addMove(const Coord move, uint64_t *seen) {
+  const int cell = board.cell(move.first, move.second);
+  const uint64_t bit = uint64_t(1) << (cell & 63);
+  if (!(seen[cell >> 6] & bit)) {
+    seen[cell >> 6] |= bit;
+    moves.push_back(move);
+  }
+}
+
+inline void Searcher::findMoves() {
+  moves.clear();
+  uint64_t seen[Board::MAX_WORDS] = {};
+
+  for (auto move : lastMoves) {
+    if (gravityOn) { // Prioritize columns from lastMoves
+      if (colHasSpace(move.first)) {
+        addMove(dropPiece(move.first), seen);
+      }
+    } else if (!gravityOn) { // Prioritize moves from lastMoves
+      if (board.isEmpty(move.first, move.second)) {
+        addMove(move, seen);
+      }
+    }
+  }
+
+  // lastMoves.clear();
+
+  if (gravityOn) { // Prioritize moves in non-empty columns & their neighbors
+    for (int col = 0; col < numCols; col++) {
+      if (colNotEmpty(col)) {
+        for (int col2 = max(0, col - 1); col2 <= min(col + 1, numCols - 1);
+             col2++) {
+          if (colHasSpace(col2)) {
+            addMove(dropPiece(col2), seen);
+          }
+        }
+      }
+    }
+  } else if (!gravityOn) { // Prioritize moves around existing pieces
+    int *near = plyMoves();
+    const int count = frontier.list(near);
+    for (int i = 0; i < count; i++) {
+      addMove(coordOf(near[i]), seen);
+    }
+  }
+
+  if (gravityOn) { // Add the rest of the non-filled columns
+    for (int col = 0; col < numCols; col++) {
+      if (colHasSpace(col)) {
+        addMove(dropPiece(col), seen);
+      }
+    }
+  } else if (!gravityOn) { // Add the rest of the pieces
+    for (int col = 0; col < numCols; col++) {
+      for (int row = 0; row < numRows; row++) {
+        if (board.isEmpty(col, row)) {
+          addMove({col, row}, seen);
+        }
+      }
+    }
+  }
+}
+
+inline const Coord Searcher::coordOf(const int cell) const {
+  return {board.colOf(cell), board.rowOf(cell)};
+}
+
+// The move stack slice of the node at the current ply.
+inline int *Searcher::plyMoves() {
+  return &moveStack[path.size() * maxMoves];
+}
+
+// Rows shrink by one move per ply, so row p starts after the
+// numCells + (numCells - 1) + ... + (numCells - p + 1) cells of those above.
+inline int *Searcher::pvRow(const int ply) {
+  const int cells = board.numCells();
+  return &pvTable[ply * cells - ply * (ply - 1) / 2];
+}
+
+// The best line from the current ply becomes move followed by the line the
+// child just returned.
+inline void Searcher::updatePv(const int ply, const int move) {
+  int *row = pvRow(ply);
+  const int *childRow = pvRow(ply + 1);
+  row[0] = move;
+  copy(childRow, childRow + pvLength[ply + 1], row + 1);
+  pvLength[ply] = pvLength[ply + 1] + 1;
+}
+
+// Sorts a node's moves: table move, killers, then history.
+inline void Searcher::orderMoves(int *moves, const int count, const int ply,
+                                 const int side, const int tableMove) {
+  const int *historyScores = &history[side * board.numCells()];
+  for (int i = 0; i < count; i++) {
+    const int move = moves[i];
+    if (move == tableMove) {
+      orderScores[i] = INT_MAX;
+    } else if (move == killers[ply * 2]) {
+      orderScores[i] = INT_MAX - 1;
+    } else if (move == killers[ply * 2 + 1]) {
+      orderScores[i] = INT_MAX - 2;
+    } else {
+      orderScores[i] = historyScores[move];
+    }
+  }
+  sortByScore(orderScores.get(), moves, count);
+}
+
+inline void Searcher::recordCutoff(const int move, const int depth,
+                                   const int ply, const int side) {
+  if (killers[ply * 2] != move) {
+    killers[ply * 2 + 1] = killers[ply * 2];
+    killers[ply * 2] = move;
+  }
+  int &score = history[side * board.numCells() + move];
+  score += depth * depth;
+  if (score > HISTORY_LIMIT) {
+    for (int i = 0; i < 2 * board.numCells(); i++) {
+      history[i] /= 2;
+    }
+  }
+}
+
+// Writes the moves left to a child with depth plies to search after
+// moves[i] is played into newMoves and returns how many there are: the same
+// list without it, plus the cell above it for gravity boards. A leaf needs
+// none.
+inline int Searcher::childMoves(const int *moves, const int count,
+                                const int i, const int depth,
+                                int *newMoves) const {
+  int newCount = 0;
+  if (depth == 0) {
+    return newCount;
+  }
+  const int col = board.colOf(moves[i]);
+  if (gravityOn and colHasSpace(col)) {
+    newMoves[newCount++] = board.cell(col, board.height(col));
+  }
+  for (int j = 0; j < i; j++) {
+    newMoves[newCount++] = moves[j];
+  }
+  for (int j = i + 1; j < count; j++) {
+    newMoves[newCount++] = moves[j];
+  }
+  return newCount;
+}
+
+// Near the leaves of a board without gravity, a cell far from every piece
+// can neither finish nor block a line in the plies that are left, so only
+// its small effect on the possible wins is lost by skipping it. The root and
+// the first child of every node are always searched.
+inline bool Searcher::prunable(const int move, const int i,
+                               const int depth) const {
+  return !gravityOn and depth <= options.pruneDepth and i > 0 and
+         !path.empty() and !frontier.containsEmpty(move);
+}
+
+// Late moves are rarely best once the table move, killers and history have
+// gone first. Those that do not make or stop a threat are searched a ply
+// shallower, and only those that still look good get the full depth.
+inline bool Searcher::reducible(const int move, const int i,
+                                const int depth) const {
+  return !gravityOn and options.lmrMoves > 0 and i >= options.lmrMoves and
+         depth >= options.lmrDepth and !path.empty() and
+         eval.mostInOpenWindow(move) < k - 2;
+}
+
+// A leaf is evaluated without looking at its moves, so the frontier is left
+// as it is for one.
+inline void Searcher::placePiece(const int cell, const int piece,
+                                 const bool leaf) {
+  (board.*boardPlace)(cell, piece);
+  eval.place(cell, piece);
+  if (!gravityOn and !leaf) {
+    frontier.place(cell);
+  }
+  path.push_back({cell, piece});
+}
+
+inline void Searcher::removePiece(const int cell, const int piece,
+                                  const bool leaf) {
+  (board.*boardRemove)(cell, piece);
+  eval.remove(cell, piece);
+  if (!gravityOn and !leaf) {
+    frontier.remove(cell);
+  }
+  path.pop_back();
+}
+
+// Full-board recount of the possible-wins heuristic on the bitboards. The
+// search uses the incrementally updated Evaluator instead; this is kept as
+// the reference it is checked against in DEBUG builds.
+int Searcher::scanEval() const {
+  int maxWins, maxPossibleWins, minWins, minPossibleWins;
+  board.countWindows(PLAYER_PIECE, maxWins, maxPossibleWins);
+  board.countWindows(OPPONENT_PIECE, minWins, minPossibleWins);
+  if (minWins) {
+    return MINWIN;
+  } else if (maxWins) {
+    return MAXWIN;
+  }
+  return maxPossibleWins - minPossibleWins;
+}
+
+inline int Searcher::staticEval() const {
+  int score;
+  if (eval.minWins()) {
+    score = MINWIN;
+  } else if (eval.maxWins()) {
+    score = MAXWIN;
+  } else if (eval.hasPatterns()) {
+    score = max(-PATTERN_LIMIT, min(eval.patternScore(), PATTERN_LIMIT));
+  } else {
+    score = eval.maxPossibleWins() - eval.minPossibleWins();
+  }
+  if (DEBUG and !eval.hasPatterns() and score != scanEval()) {
+    cout << "staticEval: Incremental score " << score
+         << " does not match rescan " << scanEval() << endl;
+  }
+  return score;
+}
+
+int Searcher::rootEval() const { return staticEval(); }
+
+int Searcher::rootMoves() {
+  findMoves();
+  return moves.size();
+}
+
+int Searcher::rootPlacements() {
+  int count = 0;
+  for (int cell = 0; cell < board.numCells(); cell++) {
+    if (board.isEmpty(cell)) {
+      placePiece(cell, PLAYER_PIECE, true);
+      removePiece(cell, PLAYER_PIECE, true);
+      count++;
+    }
+  }
+  return count;
+}
+
+// At the horizon, a win the side to move can force with fours is as good as
+// one on the board. Scoring patterns without gravity, a four the side to
+// move can complete, or two cells that complete fours of the other side
+// (which it cannot both block), are scored as traps, just short of a win.
+inline int Searcher::leafEval(const int evalScore, const int piece) {
+  if (eval.hasPatterns() and !gravityOn and evalScore != MINWIN and
+      evalScore != MAXWIN) {
+    const int trap = piece == PLAYER_PIECE ? TRAP_SCORE : -TRAP_SCORE;
+    if (eval.threatCellsOf(piece)) {
+      return trap;
+    } else if (eval.threatCellsOf(-piece) >= 2) {
+      return -trap;
+    }
+  }
+  if (options.threatLeaves and evalScore != MINWIN and evalScore != MAXWIN and
+      threats.findWin(piece, false, LEAF_THREAT_DEPTH, LEAF_THREAT_NODES) >=
+          0) {
+    return piece == PLAYER_PIECE ? MAXWIN : MINWIN;
+  }
+  return evalScore;
+}
+
+// Mirrored and rotated copies of a position share one table entry, with the
+// best move stored as seen from the canonical orientation.
+inline uint64_t Searcher::tableKey(int &symmetry) const {
+  if (options.symmetry) {
+    return board.canonicalHash(symmetry);
+  }
+  symmetry = 0;
+  return board.hash();
+}
+
+// Looks up the current position in the transposition table. Returns true with
+// the stored score if it is deep and tight enough to answer the search
+// directly; otherwise sets tableMove to the stored best move, or -1.
+inline bool Searcher::probeTable(const int depth, const int a, const int b,
+                                int &score, int &tableMove) const {
+  int symmetry;
+  TTEntry entry;
+  tableMove = -1;
+  if (!tt.probe(tableKey(symmetry), entry)) {
+    return false;
+  }
+  if (entry.depth >= depth) {
+    score = entry.score;
+    if (entry.bound == TranspositionTable::EXACT or
+        (entry.bound == TranspositionTable::LOWER and score >= b) or
+        (entry.bound == TranspositionTable::UPPER and score <= a)) {
+      return true;
+    }
+  }
+  if (entry.move >= 0) {
+    tableMove = board.inverseTransformCell(entry.move, symmetry);
+  }
+  return false;
+}
+
+inline void Searcher::storeTable(const int depth, const int a, const int b,
+                                const int score, const int bestMove) {
+  TranspositionTable::Bound bound = TranspositionTable::EXACT;
+  if (score <= a) {
+    bound = TranspositionTable::UPPER;
+  } else if (score >= b) {
+    bound = TranspositionTable::LOWER;
+  }
+  int symmetry;
+  const uint64_t key = tableKey(symmetry);
+  const int move =
+      (bestMove >= 0) ? board.transformCell(bestMove, symmetry) : -1;
+  tt.store(key, depth, score, bound, move);
+}
+
+// Plays moves[i] and searches the position after it. A reducible move gets a
+// null-window search one ply shallower first, which settles it if it fails
+// low. With PVS, children other than the first are expected to be no better
+// than the best so far: they get a null-window scout first, and the full
+// window only if the scout says otherwise.
+inline int Searcher::searchChild(const int *moves, const int count,
+                                 const int i, const int depth, const int a,
+                                 const int b, const bool maximizing,
+                                 const bool fullWindow) {
+  const int move = moves[i];
+  const bool reduce = !fullWindow and reducible(move, i, depth);
+  const bool scout = options.algorithm == SearchOptions::PVS and !fullWindow;
+  const bool leaf = depth == 1;
+  int score = 0;
+  bool settled = false;
+  if (maximizing) {
+    placePiece(move, PLAYER_PIECE, leaf);
+    int *newMoves = plyMoves();
+    const int newCount = childMoves(moves, count, i, depth - 1, newMoves);
+    if (reduce) {
+      score = minPlayer(newMoves, newCount, depth - 2, a, a + 1);
+      settled = score <= a or aborted();
+    }
+    if (!settled and scout) {
+      score = minPlayer(newMoves, newCount, depth - 1, a, a + 1);
+      settled = score <= a or score >= b or aborted();
+    }
+    if (!settled) {
+      score = minPlayer(newMoves, newCount, depth - 1, a, b);
+    }
+    removePiece(move, PLAYER_PIECE, leaf);
+  } else {
+    placePiece(move, OPPONENT_PIECE, leaf);
+    int *newMoves = plyMoves();
+    const int newCount = childMoves(moves, count, i, depth - 1, newMoves);
+    if (reduce) {
+      score = maxPlayer(newMoves, newCount, depth - 2, b - 1, b);
+      settled = score >= b or aborted();
+    }
+    if (!settled and scout) {
+      score = maxPlayer(newMoves, newCount, depth - 1, b - 1, b);
+      settled = score >= b or score <= a or aborted();
+    }
+    if (!settled) {
+      score = maxPlayer(newMoves, newCount, depth - 1, a, b);
+    }
+    removePiece(move, OPPONENT_PIECE, leaf);
+  }
+  return score;
+}
+
+inline int Searcher::minPlayer(int *moves, const int count, const int depth,
+                                int a, int b) {
+  nodes++;
+  const int ply = path.size();
+  pvLength[ply] = 0;
+  const int evalScore = staticEval();
+  if ((depth == 0) or (evalScore == MINWIN) or (evalScore == MAXWIN) or
+      count == 0) {
+    return depth ? evalScore : leafEval(evalScore, OPPONENT_PIECE);
+  }
+
+  int tableScore, tableMove;
+  if (probeTable(depth, a, b, tableScore, tableMove)) {
+    return tableScore;
+  }
+  orderMoves(moves, count, ply, 1, tableMove);
+  const int aOrig = a, bOrig = b;
+
+  int worstScore = MAXWIN;
+
+  for (int i = 0; i < count; i++) {
+    const int move = moves[i];
+    if (prunable(move, i, depth)) {
+      continue;
+    }
+    const int stateScore =
+        searchChild(moves, count, i, depth, a, b, false, i == 0);
+    if (stateScore < worstScore) {
+      worstScore = stateScore;
+      updatePv(ply, move);
+    }
+    b = min(stateScore, b);
+
+    checkTime();
+
+    if (aborted()) {
+      break;
+    }
+    if (a >= b) {
+      recordCutoff(move, depth, ply, 1);
+      break;
+    }
+    if (i == 0 and canSplit(depth)) {
+      split(moves, count, depth, false, a, b, worstScore);
+      break;
+    }
+  }
+
+  if (!aborted()) {
+    const int bestMove = pvLength[ply] ? pvRow(ply)[0] : -1;
+    storeTable(depth, aOrig, bOrig, worstScore, bestMove);
+  }
+
+  return worstScore;
+}
+
+inline int Searcher::maxPlayer(int *moves, const int count, const int depth,
+                                int a, int b) {
+  nodes++;
+  const int ply = path.size();
+  pvLength[ply] = 0;
+  const int evalScore = staticEval();
+  if ((depth == 0) or (evalScore == MINWIN) or (evalScore == MAXWIN) or
+      count == 0) {
+    return depth ? evalScore : leafEval(evalScore, PLAYER_PIECE);
+  }
+
+  int tableScore, tableMove;
+  if (probeTable(depth, a, b, tableScore, tableMove)) {
+    return tableScore;
+  }
+  orderMoves(moves, count, ply, 0, tableMove);
+  const int aOrig = a, bOrig = b;
+
+  int bestScore = MINWIN;
+
+  for (int i = 0; i < count; i++) {
+    const int move = moves[i];
+    if (prunable(move, i, depth)) {
+      continue;
+    }
+    const int stateScore =
+        searchChild(moves, count, i, depth, a, b, true, i == 0);
+    if (stateScore > bestScore) {
+      bestScore = stateScore;
+      updatePv(ply, move);
+    }
+    a = max(bestScore, a);
+
+    checkTime();
+
+    if (aborted()) {
+      break;
+    }
+    if (a >= b) {
+      recordCutoff(move, depth, ply, 0);
+      break;
+    }
+    if (i == 0 and canSplit(depth)) {
+      split(moves, count, depth, true, a, b, bestScore);
+      break;
+    }
+  }
+
+  if (!aborted()) {
+    const int bestMove = pvLength[ply] ? pvRow(ply)[0] : -1;
+    storeTable(depth, aOrig, bOrig, bestScore, bestMove);
+  }
+
+  return bestScore;
+}
+
+// Whether the current search has to be abandoned: time is up, or a sibling
+// searched by another thread caused a cutoff in a split point this search
+// belongs to.
+inline bool Searcher::aborted() const {
+  if (control.outOfTime) {
+    return true;
+  }
+  for (const SplitPoint *sp = activeSplit; sp; sp = sp->parent) {
+    if (sp->cutoff) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline bool Searcher::canSplit(const int depth) const {
+  return pool and depth >= options.splitDepth and numSplits < MAX_SPLITS and
+         pool->hasIdleWorker();
+}
+
+// Offers the remaining children of the current node (all but the eldest,
+// already searched) to the thread pool, takes part in searching them, and
+// waits for the other threads to finish before returning the merged result.
+void Searcher::split(const int *moves, const int count, const int depth,
+                     const bool maximizing, int &a, int &b, int &bestScore) {
+  const int ply = path.size();
+  SplitPoint &sp = splitPoints[numSplits++];
+  sp.parent = activeSplit;
+  sp.master = this;
+  sp.path.assign(path.begin(), path.end());
+  sp.moves.assign(moves, moves + count);
+  sp.depth = depth;
+  sp.maximizing = maximizing;
+  sp.nextMove = 1;
+  sp.a = a;
+  sp.b = b;
+  sp.bestScore = bestScore;
+  sp.pv.assign(pvRow(ply), pvRow(ply) + pvLength[ply]);
+  sp.cutoffMove = -1;
+  sp.cutoff = false;
+  sp.activeTasks = 0;
+
+  pool->publish(&sp);
+  int moveIndex;
+  while (pool->takeMove(&sp, moveIndex)) {
+    searchSplitMove(sp, moveIndex);
+  }
+  pool->retract(&sp);
+  // Until the other threads are done, help them with the split points they
+  // open below this one: work that never keeps the master from returning.
+  SplitPoint *child;
+  while (pool->helpBelow(&sp, child, moveIndex)) {
+    searchSplitMove(*child, moveIndex);
+  }
+
+  a = sp.a;
+  b = sp.b;
+  bestScore = sp.bestScore;
+  copy(sp.pv.begin(), sp.pv.end(), pvRow(ply));
+  pvLength[ply] = sp.pv.size();
+  if (sp.cutoffMove >= 0) {
+    recordCutoff(sp.cutoffMove, depth, ply, maximizing ? 0 : 1);
+  }
+  numSplits--;
+}
+
+void Searcher::searchSplitMove(SplitPoint &sp, const int moveIndex) {
+  // Threads other than the master replay the path down to the split node
+  // from where they are: the root, or for a master helping below its own
+  // split point, that point's node.
+  const bool helping = sp.master != this;
+  const int start = path.size();
+  if (helping) {
+    for (int i = start; i < int(sp.path.size()); i++) {
+      placePiece(sp.path[i].first, sp.path[i].second);
+    }
+  }
+  SplitPoint *const outerSplit = activeSplit;
+  activeSplit = &sp;
+
+  int a, b;
+  {
+    lock_guard<mutex> guard(sp.lock);
+    a = sp.a;
+    b = sp.b;
+  }
+  const int *splitMoves = sp.moves.data();
+  const int count = sp.moves.size();
+  const int move = splitMoves[moveIndex];
+  const int ply = path.size();
+  const bool pruned = prunable(move, moveIndex, sp.depth);
+  const int stateScore =
+      pruned ? 0
+             : searchChild(splitMoves, count, moveIndex, sp.depth, a, b,
+                           sp.maximizing, false);
+
+  if (!pruned and !aborted()) {
+    lock_guard<mutex> guard(sp.lock);
+    const bool improved = sp.maximizing ? (stateScore > sp.bestScore)
+                                        : (stateScore < sp.bestScore);
+    if (improved) {
+      sp.bestScore = stateScore;
+      const int *childRow = pvRow(ply + 1);
+      sp.pv.clear();
+      sp.pv.push_back(move);
+      sp.pv.insert(sp.pv.end(), childRow, childRow + pvLength[ply + 1]);
+    }
+    if (sp.maximizing) {
+      sp.a = max(sp.a, stateScore);
+    } else {
+      sp.b = min(sp.b, stateScore);
+    }
+    if (sp.a >= sp.b and !sp.cutoff) {
+      sp.cutoff = true;
+      sp.cutoffMove = move;
+    }
+  }
+
+  activeSplit = outerSplit;
+  if (helping) {
+    for (int i = int(sp.path.size()) - 1; i >= start; i--) {
+      removePiece(sp.path[i].first, sp.path[i].second);
+    }
+  }
+  pool->finishMove(&sp);
+}
+
+void Searcher::playMove(const int cell, const int piece) {
+  board.place(cell, piece);
+  eval.place(cell, piece);
+  frontier.place(cell);
+}
+
+void Searcher::takeBackMove(const int cell, const int piece) {
+  board.remove(cell, piece);
+  eval.remove(cell, piece);
+  frontier.remove(cell);
+}
+
+// Searches the root with the window [alpha, beta]. A score at or outside
+// the window is only a bound on the true one.
+const pair<Coord, int> Searcher::startMiniMax(const int depth, const int alpha,
+                                              const int beta) {
+  uniform_int_distribution<int> uni(0, moves.size() - 1);
+  Coord bestMove = moves[uni(rng)];
+  int a = alpha;
+  int b = beta;
+  int bestScore = MINWIN; // lost = true
+
+  // Only the thread reporting the result prints its search.
+  const bool debugOutput = DEBUG and threadIndex == 0;
+  vector<vector<int>> scoreBoard;
+  if (debugOutput) {
+    scoreBoard.resize(numCols, vector<int>(numRows, 0));
+  }
+
+  // The root's moves are the bottom of the move stack.
+  int *rootMoves = plyMoves();
+  const int count = moves.size();
+  for (int i = 0; i < count; i++) {
+    rootMoves[i] = board.cell(moves[i].first, moves[i].second);
+  }
+  pvRow(0)[0] = board.cell(bestMove.first, bestMove.second);
+  pvLength[0] = 1;
+  rootScores.assign(count, MINWIN);
+
+  for (int i = 0; i < count; i++) {
+    const Coord move = moves[i];
+    const int stateScore =
+        searchChild(rootMoves, count, i, depth, a, b, true, i == 0);
+    if (stateScore > bestScore) {
+      bestScore = stateScore;
+      updatePv(0, rootMoves[i]);
+      bestMove = move;
+    }
+    a = max(bestScore, a);
+    rootScores[i] = stateScore;
+
+    if (debugOutput) {
+      scoreBoard[move.first][move.second] = stateScore;
+    }
+
+    checkTime();
+
+    if (a >= b or control.outOfTime) {
+      break;
+    }
+  }
+
+  if (debugOutput and !control.outOfTime) {
+    // Print score board
+    for (int y = numRows - 1; y >= 0; y--) {
+      cout << "[\t";
+      for (int x = 0; x < numCols; x++) {
+        if (board.pieceAt(x, y) == PLAYER_PIECE) {
+          cout << "[P]\t";
+        } else if (board.pieceAt(x, y) == OPPONENT_PIECE) {
+          cout << "[E]\t";
+        } else if (x == bestMove.first and y == bestMove.second) {
+          cout << "(";
+          if (scoreBoard[x][y] == MAXWIN) {
+            cout << "W!";
+          } else if (scoreBoard[x][y] == MINWIN) {
+            cout << "L!";
+          } else {
+            cout << scoreBoard[x][y];
+          }
+          cout << ")\t";
+        } else {
+          if (scoreBoard[x][y] == MAXWIN) {
+            cout << "W!\t";
+          } else if (scoreBoard[x][y] == MINWIN) {
+            cout << "L!\t";
+          } else if (find(moves.begin(), moves.end(), Coord{x, y}) !=
+                     moves.end()) {
+            cout << scoreBoard[x][y] << "\t";
+          } else {
+            cout << "-\t";
+          }
+        }
+      }
+      cout << "]" << endl;
+    }
+    // Print expected path
+    cout << "Expected path: ";
+    for (int i = 0; i < pvLength[0]; i++) {
+      if (i != 0) {
+        cout << "->";
+      }
+      const Coord move = coordOf(pvRow(0)[i]);
+      cout << "(" << move.first << ", " << move.second << ")";
+    }
+    cout << endl << endl;
+  }
+
+  return {bestMove, bestScore};
+}
+
+
+const pair<Coord, int> Searcher::searchIteration(const int depth,
+                                                 const bool haveGuess,
+                                                 const int guess) {
+  const bool debugOutput = DEBUG and threadIndex == 0;
+  if (!haveGuess or guess <= MINWIN or guess >= MAXWIN) {
+    return startMiniMax(depth);
+  }
+
+  if (options.algorithm == SearchOptions::MTDF) {
+    // Each null-window search tells whether the score is below g or not,
+    // moving one of the bounds until they meet. The table keeps the passes
+    // cheap. The move is that of the last pass to fail high, the only kind
+    // that proves a move reaches its bound.
+    int lower = MINWIN, upper = MAXWIN, g = guess;
+    pair<Coord, int> result, best = {{-1, -1}, MINWIN};
+    while (lower < upper) {
+      const int beta = (g == lower) ? g + 1 : g;
+      result = startMiniMax(depth, beta - 1, beta);
+      if (control.outOfTime) {
+        return result;
+      }
+      g = result.second;
+      if (g < beta) {
+        upper = g;
+      } else {
+        lower = g;
+        best = result;
+        bestPv.assign(pvRow(0), pvRow(0) + pvLength[0]);
+      }
+    }
+    if (best.first.first < 0) {
+      return result; // every move loses
+    }
+    copy(bestPv.begin(), bestPv.end(), pvRow(0));
+    pvLength[0] = bestPv.size();
+    return {best.first, g};
+  }
+
+  if (!options.aspiration) {
+    return startMiniMax(depth);
+  }
+  // Aspiration: a narrow window around the guess prunes more, and is
+  // widened on the failing side until the score falls inside it.
+  int delta = ASPIRATION_WINDOW;
+  int alpha = threatOutcome < 0 ? MINWIN : max(int(MINWIN), guess - delta);
+  int beta = threatOutcome > 0 ? MAXWIN : min(int(MAXWIN), guess + delta);
+  while (true) {
+    const pair<Coord, int> result = startMiniMax(depth, alpha, beta);
+    const int score = result.second;
+    if (control.outOfTime) {
+      return result;
+    } else if (score <= alpha and alpha > MINWIN) {
+      alpha = max(int(MINWIN), score - delta);
+    } else if (score >= beta and beta < MAXWIN) {
+      beta = min(int(MAXWIN), score + delta);
+    } else {
+      return result;
+    }
+    delta *= 2;
+    if (debugOutput) {
+      cout << "Score " << score << " outside the aspiration window; "
+           << "searching [" << alpha << ", " << beta << "]." << endl;
+    }
+  }
+}
+
+// Lazy SMP depth schedule: helper threads skip some depths, staggered by
+// thread, so that they tend to run ahead of the main thread and fill the
+// shared table with deeper results instead of repeating its work.
+static inline bool skipDepth(const int threadIndex, const int depth) {
+  static const int skipSize[] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+  static const int skipPhase[] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                                  4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+  if (threadIndex == 0) {
+    return false;
+  }
+  const int i = (threadIndex - 1) % 20;
+  return ((depth + skipPhase[i]) / skipSize[i]) % 2 != 0;
+}
+
+const pair<Coord, int> Searcher::runIDS() {
+  const bool debugOutput = DEBUG and threadIndex == 0;
+  nodes = 0;
+  depthReached = 0;
+  timeWasted = Clock::duration::zero();
+  lastPoll = Clock::now();
+  fill(killers.get(), killers.get() + (board.numCells() + 1) * 2, -1);
+  for (int i = 0; i < 2 * board.numCells(); i++) {
+    history[i] /= 2;
+  }
+  findMoves();
+  lastMoves.clear();
+  const int maxDepth = options.maxDepth;
+  // A win by fours is proven in a fraction of the time the search would
+  // take to see it, and played at once. Threes are another matter: the
+  // threat search only tries the replies on a three's proof and the
+  // defender's fours, so a win or loss by threes is a guess, which puts its
+  // move first and opens the aspiration window on its side.
+  threatOutcome = 0;
+  if (threadIndex == 0 and options.threatDepth > 0) {
+    const int win = threats.findWin(PLAYER_PIECE, false, options.threatDepth,
+                                    ROOT_THREAT_NODES);
+    if (debugOutput) {
+      cout << "Threat search: " << (win >= 0 ? "forced win" : "no win")
+           << " in " << threats.nodes << " nodes" << endl;
+    }
+    if (win >= 0) {
+      lastMoves.push_back(coordOf(win));
+      return {coordOf(win), MAXWIN};
+    }
+    const int likelyWin = threats.findWin(
+        PLAYER_PIECE, true, options.threatDepth, ROOT_THREAT_NODES);
+    if (likelyWin >= 0) {
+      threatOutcome = 1;
+      auto first = find(moves.begin(), moves.end(), coordOf(likelyWin));
+      if (first != moves.end()) {
+        rotate(moves.begin(), first, first + 1);
+      }
+    } else if (threats.cannotStop(OPPONENT_PIECE, options.threatDepth,
+                                  ROOT_THREAT_NODES)) {
+      threatOutcome = -1;
+    }
+    if (debugOutput and threatOutcome != 0) {
+      cout << "Threat search: likely " << (threatOutcome > 0 ? "win" : "loss")
+           << " by threes" << endl;
+    }
+  }
+  int bestScore = MINWIN;
+  Coord bestMove = moves[0];
+  // Iteration budgeting, done by the main thread: the next iteration is
+  // expected to take as much longer than the last one as the effective
+  // branching factor (the ratio of their node counts) says.
+  Clock::duration lastTime{0};
+  long long lastNodes = 0;
+  double branching = 0; // unknown until two iterations have completed
+  int stableIterations = 0;
+  // Scores swing between odd and even depths, as the side to move last
+  // changes, so the guess for a depth is the score of the one two before.
+  int guesses[2];
+  bool haveGuess[2] = {false, false};
+
+  for (int depth = 1; !control.outOfTime and bestScore < MAXWIN and
+                      (gravityOn or depth <= moves.size()) and
+                      (maxDepth == 0 or depth <= maxDepth);
+       depth++) {
+    if (skipDepth(threadIndex, depth)) {
+      continue;
+    }
+    if (debugOutput) {
+      cout << "Searching with depth " << depth << "..." << endl;
+    }
+    const Clock::time_point iterationStart = Clock::now();
+    const long long nodesBefore = nodes;
+    Coord currentMove;
+    int currentScore;
+    tie(currentMove, currentScore) =
+        searchIteration(depth, haveGuess[depth % 2], guesses[depth % 2]);
+    // A finished iteration orders the next one: root moves by the scores
+    // it gave them, and the expected move chain for the next move request.
+    if (!control.outOfTime) {
+      guesses[depth % 2] = currentScore;
+      haveGuess[depth % 2] = true;
+      sortByScore(rootScores.data(), moves.data(), moves.size());
+      auto best = find(moves.begin(), moves.end(), currentMove);
+      if (best != moves.end()) {
+        rotate(moves.begin(), best, best + 1);
+      }
+      lastMoves.clear();
+      for (int i = 0; i < pvLength[0]; i++) {
+        lastMoves.push_back(coordOf(pvRow(0)[i]));
+      }
+    }
+    if (!control.outOfTime and
+        (currentScore > MINWIN or bestScore == MINWIN)) {
+      stableIterations = (currentMove == bestMove) ? stableIterations + 1 : 1;
+      bestMove = currentMove;
+      bestScore = currentScore;
+      depthReached = depth;
+    }
+    if (debugOutput) {
+      cout << nodes << " nodes searched." << endl;
+    }
+    if (control.outOfTime) {
+      timeWasted = Clock::now() - iterationStart;
+      break;
+    }
+
+    const long long iterationNodes = nodes - nodesBefore;
+    if (lastNodes > 0) {
+      branching = max(1.0, double(iterationNodes) / lastNodes);
+    }
+    lastNodes = iterationNodes;
+    lastTime = Clock::now() - iterationStart;
+    if (threadIndex == 0) {
+      const bool stable = stableIterations >= STABLE_ITERATIONS;
+      const Clock::duration expected =
+          duration_cast<Clock::duration>(lastTime * branching);
+      // Without a branching factor yet, the soft deadline has to do.
+      const bool fits = (branching == 0)
+                            ? !control.time.softExpired()
+                            : stable ? control.time.fitsSoft(expected)
+                                     : control.time.fitsHard(expected);
+      if (!fits) {
+        if (debugOutput) {
+          cout << "Depth " << depth + 1 << " would take about "
+               << duration_cast<milliseconds>(expected).count() << "ms"
+               << (stable ? " and the best move is stable." : ".") << endl;
+        }
+        break;
+      }
+    }
+    if (debugOutput and !control.outOfTime and
+        (!gravityOn and depth == moves.size())) {
+      cout << "Search space exhausted." << endl;
+    } else if (debugOutput and bestScore == MAXWIN) {
+      cout << "Winning move found." << endl;
+    }
+  }
+  if (debugOutput and control.outOfTime) {
+    cout << "Time limit reached; "
+         << duration_cast<milliseconds>(timeWasted).count()
+         << "ms spent on an unfinished iteration." << endl
+         << endl;
+  }
+
+  return {bestMove, bestScore};
+}
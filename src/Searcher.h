@@ -0,0 +1,174 @@
+#ifndef SEARCHER_H
+#define SEARCHER_H
+
+#include "Board.h"
+#include "Evaluator.h"
+#include "Frontier.h"
+#include "SearchOptions.h"
+#include "ThreatSearch.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+typedef std::pair<int, int> Coord;
+typedef std::vector<Coord> MovesList;
+}
+
+struct SplitPoint;
+class ThreadPool;
+
+// State shared by every thread searching the same position.
+struct SearchControl {
+    TimeManager time;
+    std::atomic<bool> outOfTime{false}; // set once the search has to stop
+};
+
+// One thread's alpha-beta search over its own copy of the board. Searchers
+// working on the same position share a transposition table and a
+// SearchControl, which is all they need to cooperate.
+class Searcher {
+  public:
+    static const int MAXWIN = 1000;
+    static const int MINWIN = -1000;
+
+  private:
+    const bool gravityOn;
+    const int numCols;
+    const int numRows;
+    const int k;
+    const int threadIndex; // 0 for the thread that reports the result
+    const SearchOptions &options;
+    TranspositionTable &tt;
+    SearchControl &control;
+    Board board;
+    // Board::place and remove, or their kernels for the board's shape when
+    // it is one of the common ones (see BoardShape.h).
+    void (Board::*boardPlace)(int cell, int piece);
+    void (Board::*boardRemove)(int cell, int piece);
+    Evaluator eval;
+    Frontier frontier; // cells within options.pruneDistance of a piece
+    ThreatSearch threats; // works on board and eval
+    MovesList moves;
+    std::mt19937 rng; // to return random move when no best move found
+    // Cells and pieces placed since the root, replayed by threads joining a
+    // split. Its length is the ply of the node being searched.
+    std::vector<std::pair<int, int>> path;
+    // Move lists of the nodes on the current line, as cell indices: ply p
+    // owns moveStack[p * maxMoves] onwards. Allocated once, so generating
+    // moves never touches the heap.
+    const int maxMoves; // most moves a node can have
+    std::unique_ptr<int[]> moveStack;
+    // Triangular principal variation table: row p holds the best line found
+    // from the node at ply p, at most numCells - p moves long, and is built
+    // from row p + 1 as the search returns.
+    std::unique_ptr<int[]> pvTable;
+    std::unique_ptr<int[]> pvLength;
+    // Move ordering: the table move first, then the two killer moves of the
+    // ply (the latest to cause a cutoff there), then the rest by a history
+    // score per side and cell that every cutoff raises by depth squared.
+    // History is kept from move to move of a game, halved at each search.
+    std::unique_ptr<int[]> killers; // [ply * 2 + slot], or -1
+    std::unique_ptr<int[]> history; // [side * numCells + cell]
+    std::unique_ptr<int[]> orderScores; // scratch for the node being sorted
+    // Root move scores from the last iteration, parallel to moves, which
+    // order the next one.
+    std::vector<int> rootScores;
+    std::vector<int> bestPv; // root line of MTD(f)'s best pass so far
+    // 1 or -1 when the threat search expects the root to be won or lost by
+    // threes, which it cannot prove; 0 otherwise.
+    int threatOutcome = 0;
+    ThreadPool *pool;          // workers for the YBW search, or null
+    SplitPoint *activeSplit = nullptr; // split point being worked on
+    static const int MAX_SPLITS = 8;
+    std::unique_ptr<SplitPoint[]> splitPoints; // one per nested split
+    int numSplits = 0;
+    // The clock is read every pollInterval calls to checkTime, an interval
+    // adapted to this thread's node rate.
+    int pollInterval = 1;
+    int untilPoll = 1;
+    Clock::time_point lastPoll;
+
+    void checkTime();
+    const Coord dropPiece(const int col) const;
+    bool colHasSpace(const int col) const;
+    void addMove(const Coord move, uint64_t *seen);
+    bool colNotEmpty(const int col) const;
+    void findMoves();
+    const Coord coordOf(const int cell) const;
+    int *plyMoves();
+    int *pvRow(const int ply);
+    void updatePv(const int ply, const int move);
+    void orderMoves(int *moves, const int count, const int ply, const int side,
+                    const int tableMove);
+    void recordCutoff(const int move, const int depth, const int ply,
+                      const int side);
+    int childMoves(const int *moves, const int count, const int i,
+                   const int depth, int *newMoves) const;
+    bool prunable(const int move, const int i, const int depth) const;
+    bool reducible(const int move, const int i, const int depth) const;
+    bool aborted() const;
+    bool canSplit(const int depth) const;
+    void split(const int *moves, const int count, const int depth,
+               const bool maximizing, int &a, int &b, int &bestScore);
+    void placePiece(const int cell, const int piece, const bool leaf = false);
+    void removePiece(const int cell, const int piece, const bool leaf = false);
+    int scanEval() const;
+    int staticEval() const;
+    int leafEval(const int evalScore, const int piece);
+    uint64_t tableKey(int &symmetry) const;
+    bool probeTable(const int depth, const int a, const int b, int &score,
+                    int &tableMove) const;
+    void storeTable(const int depth, const int a, const int b, const int score,
+                    const int bestMove);
+    int searchChild(const int *moves, const int count, const int i,
+                    const int depth, const int a, const int b,
+                    const bool maximizing, const bool fullWindow);
+    int minPlayer(int *moves, const int count, const int depth, int a, int b);
+    int maxPlayer(int *moves, const int count, const int depth, int a, int b);
+
+  public:
+    // The best move chain found by the last completed iteration, searched
+    // first by the next one.
+    MovesList lastMoves;
+    long long nodes = 0;  // positions visited by the last search
+    int depthReached = 0; // deepest iteration the last search completed
+    // Time the last search spent on an iteration the deadline cut short.
+    Clock::duration timeWasted{0};
+
+    Searcher(const Board &board, const SearchOptions &options,
+             TranspositionTable &tt, SearchControl &control,
+             int threadIndex = 0, ThreadPool *pool = nullptr);
+    ~Searcher();
+
+    // Advances the root position by a move played in the game, or takes one
+    // back.
+    void playMove(const int cell, const int piece);
+    void takeBackMove(const int cell, const int piece);
+    const std::pair<Coord, int> startMiniMax(const int depth,
+                                             const int alpha = MINWIN,
+                                             const int beta = MAXWIN);
+    // One iteration of the deepening, given the score an earlier iteration
+    // found (if any) as a guess at this one's.
+    const std::pair<Coord, int> searchIteration(const int depth,
+                                                const bool haveGuess,
+                                                const int guess);
+    // Iterative deepening until time runs out or the game is decided,
+    // returning the best root move and its score. Helper threads skip
+    // depths on a staggered schedule.
+    const std::pair<Coord, int> runIDS();
+    // Searches one move of a split point and merges the result into it.
+    void searchSplitMove(SplitPoint &splitPoint, const int moveIndex);
+    // The static evaluation of the root, and the number of moves generated
+    // for it, as a node of the search sees them; for benchmarks. So is
+    // rootPlacements, which plays and takes back a piece on every empty cell
+    // of the root and returns how many there are.
+    int rootEval() const;
+    int rootMoves();
+    int rootPlacements();
+};
+
+#endif // SEARCHER_H
@@ -0,0 +1,137 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(const Board &board, const SearchOptions &options,
+                       TranspositionTable &tt, SearchControl &control,
+                       int numWorkers) {
+    for (int i = 0; i < numWorkers; i++) {
+        workers.emplace_back(
+            new Searcher(board, options, tt, control, i + 1, this));
+    }
+    for (auto &worker : workers) {
+        Searcher *searcher = worker.get();
+        threads.emplace_back([this, searcher] { workerLoop(searcher); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::publish(SplitPoint *splitPoint) {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        splitPoints.push_back(splitPoint);
+    }
+    wakeUp.notify_all();
+}
+
+void ThreadPool::retract(SplitPoint *splitPoint) {
+    std::lock_guard<std::mutex> guard(mutex);
+    splitPoints.erase(
+        std::remove(splitPoints.begin(), splitPoints.end(), splitPoint),
+        splitPoints.end());
+}
+
+bool ThreadPool::takeMove(SplitPoint *splitPoint, int &moveIndex) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (splitPoint->cutoff or
+        splitPoint->nextMove >= int(splitPoint->moves.size())) {
+        return false;
+    }
+    moveIndex = splitPoint->nextMove++;
+    splitPoint->activeTasks++;
+    return true;
+}
+
+void ThreadPool::finishMove(SplitPoint *splitPoint) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (--splitPoint->activeTasks == 0) {
+        wakeUp.notify_all();
+    }
+}
+
+bool ThreadPool::helpBelow(SplitPoint *splitPoint, SplitPoint *&child,
+                           int &moveIndex) {
+    std::unique_lock<std::mutex> guard(mutex);
+    bool found = false;
+    wakeUp.wait(guard, [&] {
+        found = findWork(child, moveIndex, splitPoint);
+        return found or splitPoint->activeTasks == 0;
+    });
+    return found;
+}
+
+// Steals from the open split point nearest the root, where the work left
+// is largest, among those opened below the given one if any. Called with
+// the lock held.
+bool ThreadPool::findWork(SplitPoint *&splitPoint, int &moveIndex,
+                          const SplitPoint *below) {
+    splitPoint = nullptr;
+    for (SplitPoint *candidate : splitPoints) {
+        bool underneath = !below;
+        for (const SplitPoint *up = candidate->parent; up and !underneath;
+             up = up->parent) {
+            underneath = up == below;
+        }
+        if (underneath and !candidate->cutoff and
+            candidate->nextMove < int(candidate->moves.size()) and
+            (!splitPoint or candidate->depth > splitPoint->depth)) {
+            splitPoint = candidate;
+        }
+    }
+    if (!splitPoint) {
+        return false;
+    }
+    moveIndex = splitPoint->nextMove++;
+    splitPoint->activeTasks++;
+    return true;
+}
+
+void ThreadPool::workerLoop(Searcher *worker) {
+    while (true) {
+        SplitPoint *splitPoint;
+        int moveIndex;
+        {
+            std::unique_lock<std::mutex> guard(mutex);
+            idleWorkers++;
+            wakeUp.wait(guard, [&] {
+                return stopping or findWork(splitPoint, moveIndex);
+            });
+            idleWorkers--;
+            if (stopping) {
+                return;
+            }
+        }
+        worker->searchSplitMove(*splitPoint, moveIndex);
+    }
+}
+
+void ThreadPool::playMove(const int cell, const int piece) {
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto &worker : workers) {
+        worker->playMove(cell, piece);
+    }
+}
+
+void ThreadPool::takeBackMove(const int cell, const int piece) {
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto &worker : workers) {
+        worker->takeBackMove(cell, piece);
+    }
+}
+
+long long ThreadPool::nodes() const {
+    long long total = 0;
+    for (auto &worker : workers) {
+        total += worker->nodes;
+    }
+    return total;
+}
@@ -0,0 +1,84 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "Searcher.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A node whose remaining children are being searched by several threads
+// (Young Brothers Wait: only after its eldest child has been searched).
+//
+// The thread that created it is its master; idle threads steal moves from it
+// one at a time. Results are merged under lock, and a cutoff found by any of
+// them is seen by the others through Searcher::aborted(). A move starts from
+// the window the split point has when it is taken; one already being
+// searched keeps its window, and only a cutoff reaches it.
+struct SplitPoint {
+    SplitPoint *parent = nullptr; // enclosing split point of the master
+    Searcher *master = nullptr;
+    // Cells and pieces placed from the root to reach this node, for other
+    // threads to replay on their own boards.
+    std::vector<std::pair<int, int>> path;
+    std::vector<int> moves; // cell indices
+    int depth = 0;
+    bool maximizing = true;
+    int nextMove = 0; // guarded by the pool's lock
+
+    std::mutex lock; // guards the fields below
+    int a = 0, b = 0;
+    int bestScore = 0;
+    std::vector<int> pv; // best line from this node, as cell indices
+    int cutoffMove = -1; // for the master's killers and history
+
+    std::atomic<bool> cutoff{false};
+    // Moves being searched right now, changed under the pool's lock.
+    std::atomic<int> activeTasks{0};
+};
+
+// Worker threads for the YBW search. Workers sleep until a split point is
+// published and then take its moves until none are left.
+class ThreadPool {
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::vector<SplitPoint *> splitPoints; // open for stealing
+    std::vector<std::unique_ptr<Searcher>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<int> idleWorkers{0};
+    bool stopping = false;
+
+    bool findWork(SplitPoint *&splitPoint, int &moveIndex,
+                  const SplitPoint *below = nullptr);
+    void workerLoop(Searcher *worker);
+
+  public:
+    ThreadPool(const Board &board, const SearchOptions &options,
+               TranspositionTable &tt, SearchControl &control,
+               int numWorkers);
+    ~ThreadPool();
+
+    bool hasIdleWorker() const { return idleWorkers > 0; }
+    void publish(SplitPoint *splitPoint);
+    void retract(SplitPoint *splitPoint);
+    // Claims the next unsearched move of a split point, if any.
+    bool takeMove(SplitPoint *splitPoint, int &moveIndex);
+    // Called by the thread that searched a move of splitPoint when it is
+    // done with it.
+    void finishMove(SplitPoint *splitPoint);
+    // For the master of a split point that has no moves left to take: waits
+    // until a move of a split point opened below it can be claimed, and
+    // returns true, or until the split point's last move is done, and
+    // returns false.
+    bool helpBelow(SplitPoint *splitPoint, SplitPoint *&child,
+                   int &moveIndex);
+    // Plays or takes back a move of the game on every worker's board. Only
+    // called between searches, while the workers are asleep.
+    void playMove(const int cell, const int piece);
+    void takeBackMove(const int cell, const int piece);
+    long long nodes() const;
+};
+
+#endif // THREADPOOL_H
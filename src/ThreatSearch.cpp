@@ -0,0 +1,230 @@
+#include "ThreatSearch.h"
+#include <algorithm>
+
+// Moves of the attacker and replies of the defender each take a ply, and a
+// three adds the ply of the VCF that proves it.
+ThreatSearch::ThreatSearch(Board &board, Evaluator &eval)
+    : board{board}, eval{eval}, k{board.k()},
+      moveStack{new int[(2 * MAX_DEPTH + 3) * board.numCells()]},
+      seen{new bool[board.numCells()]()}, line{new int[board.numCells()]},
+      proof{new int[board.numCells() + 2]} {}
+
+inline bool ThreatSearch::playable(int cell) const {
+    if (!board.isEmpty(cell)) {
+        return false;
+    }
+    return !board.gravityOn() or
+           board.height(board.colOf(cell)) == board.rowOf(cell);
+}
+
+// Playable cells that would complete a line for the side of piece, up to
+// two of them.
+int ThreatSearch::winSquares(int piece, int *squares) const {
+    int count = 0;
+    for (int w = 0; w < eval.numWindows(); w++) {
+        if (eval.piecesIn(w, piece) != k - 1 or eval.piecesIn(w, -piece)) {
+            continue;
+        }
+        for (int i = 0; i < k; i++) {
+            const int cell = eval.windowCell(w, i);
+            if (board.isEmpty(cell)) {
+                if (playable(cell) and (count == 0 or squares[0] != cell)) {
+                    squares[count++] = cell;
+                }
+                break;
+            }
+        }
+        if (count == 2) {
+            break;
+        }
+    }
+    return count;
+}
+
+inline int ThreatSearch::addMove(int *moves, int count, int cell) {
+    if (!seen[cell] and playable(cell)) {
+        seen[cell] = true;
+        moves[count++] = cell;
+    }
+    return count;
+}
+
+// Appends the fours of the side of piece, then its threes if asked for.
+int ThreatSearch::addThreatMoves(int piece, bool threes, int *moves,
+                                 int count) {
+    const int fewest = std::max(1, threes ? k - 3 : k - 2);
+    for (int need = k - 2; need >= fewest; need--) {
+        for (int w = 0; w < eval.numWindows(); w++) {
+            if (eval.piecesIn(w, piece) != need or eval.piecesIn(w, -piece)) {
+                continue;
+            }
+            for (int i = 0; i < k; i++) {
+                count = addMove(moves, count, eval.windowCell(w, i));
+            }
+        }
+    }
+    return count;
+}
+
+inline void ThreatSearch::clearSeen(const int *moves, int count) {
+    for (int i = 0; i < count; i++) {
+        seen[moves[i]] = false;
+    }
+}
+
+inline void ThreatSearch::play(int cell, int piece) {
+    board.place(cell, piece);
+    eval.place(cell, piece);
+    line[lineLength++] = cell;
+}
+
+inline void ThreatSearch::undo(int cell, int piece) {
+    board.remove(cell, piece);
+    eval.remove(cell, piece);
+    lineLength--;
+}
+
+void ThreatSearch::recordProof(const int *squares, int count) {
+    if (proofStart < 0) {
+        return;
+    }
+    proofLength = 0;
+    for (int i = proofStart; i < lineLength; i++) {
+        proof[proofLength++] = line[i];
+    }
+    for (int i = 0; i < count; i++) {
+        proof[proofLength++] = squares[i];
+    }
+}
+
+// The side of piece is to move. Returns whether it can force a win with
+// threats in at most depth moves.
+bool ThreatSearch::attack(int piece, int depth, int ply, bool threes) {
+    if (++nodes > nodeLimit) {
+        return false;
+    }
+    int squares[2];
+    if (winSquares(piece, squares) > 0) {
+        recordProof(squares, 1);
+        if (lineLength == 0) {
+            firstMove = squares[0];
+        }
+        return true;
+    }
+    if (depth == 0) {
+        return false;
+    }
+    // A four of the defender has to be blocked, and the block has to be a
+    // threat itself for the attack to go on.
+    int blocks[2];
+    const int numBlocks = winSquares(-piece, blocks);
+    if (numBlocks > 1) {
+        return false;
+    }
+
+    int *moves = &moveStack[ply * board.numCells()];
+    const int count = addThreatMoves(piece, threes, moves, 0);
+    clearSeen(moves, count);
+    for (int i = 0; i < count; i++) {
+        const int move = moves[i];
+        if (numBlocks and move != blocks[0]) {
+            continue;
+        }
+        play(move, piece);
+        bool won = false;
+        int counters[2];
+        if (winSquares(-piece, counters) == 0) {
+            const int wins = winSquares(piece, squares);
+            if (wins == 2) {
+                recordProof(squares, 2);
+                won = true;
+            } else if (wins == 1) {
+                play(squares[0], -piece);
+                won = attack(piece, depth - 1, ply + 1, threes);
+                undo(squares[0], -piece);
+            } else if (threes) {
+                won = defend(piece, depth - 1, ply + 1);
+            }
+        }
+        undo(move, piece);
+        if (won) {
+            if (lineLength == 0) {
+                firstMove = move;
+            }
+            return true;
+        }
+        if (numBlocks) {
+            break;
+        }
+    }
+    return false;
+}
+
+// The side of piece has just made a three and the other side is to move,
+// with no four on the board. Returns whether every answer still loses.
+bool ThreatSearch::defend(int piece, int depth, int ply) {
+    proofStart = lineLength;
+    const bool threat = attack(piece, depth, ply + 1, false);
+    proofStart = -1;
+    if (!threat) {
+        return false;
+    }
+
+    // Any cell the VCF needs breaks it, and on gravity boards so does the
+    // move that fills its column up to it. Fours of the defender's own
+    // have to be answered first, and so may its threes: a stone off the
+    // proof can make a four with a block the VCF forces later.
+    int *moves = &moveStack[ply * board.numCells()];
+    int count = 0;
+    for (int i = 0; i < proofLength; i++) {
+        int cell = proof[i];
+        const int col = board.colOf(cell);
+        if (board.gravityOn() and board.colHasSpace(col)) {
+            cell = board.cell(col, board.height(col));
+        }
+        count = addMove(moves, count, cell);
+    }
+    count = addThreatMoves(-piece, true, moves, count);
+    clearSeen(moves, count);
+
+    for (int i = 0; i < count; i++) {
+        play(moves[i], -piece);
+        const bool won = attack(piece, depth, ply + 1, true);
+        undo(moves[i], -piece);
+        if (!won) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int ThreatSearch::findWin(int piece, bool threes, int depth,
+                          long long maxNodes) {
+    nodes = 0;
+    nodeLimit = maxNodes;
+    firstMove = -1;
+    if (attack(piece, std::min(depth, MAX_DEPTH), 0, threes)) {
+        return firstMove;
+    }
+    return -1;
+}
+
+bool ThreatSearch::cannotStop(int piece, int depth, long long maxNodes) {
+    nodes = 0;
+    nodeLimit = maxNodes;
+    depth = std::min(depth, MAX_DEPTH);
+    int squares[2];
+    if (winSquares(-piece, squares) > 0) {
+        return false;
+    }
+    const int wins = winSquares(piece, squares);
+    if (wins == 2) {
+        return true;
+    } else if (wins == 1) {
+        play(squares[0], -piece);
+        const bool won = attack(piece, depth, 1, true);
+        undo(squares[0], -piece);
+        return won;
+    }
+    return defend(piece, depth, 0);
+}
@@ -0,0 +1,70 @@
+#ifndef THREATSEARCH_H
+#define THREATSEARCH_H
+
+#include "Board.h"
+#include "Evaluator.h"
+#include <memory>
+
+// Threat-space search: looks for forced wins among the moves that threaten
+// to win, which are few enough to search far deeper than alpha-beta can.
+//
+// A four leaves a window with k - 1 of the attacker's pieces and none of the
+// defender's, so the defender has to take its last cell; two at once win. A
+// three leaves k - 2 in an open window. It is only a threat if the attacker,
+// given a free move, would win by fours alone (VCF), and the defender may
+// answer it on any cell that win used or with a four of its own. Searching
+// fours only proves a VCF; adding threes proves a win by continuous threats
+// (VCT). On gravity boards a cell counts only once it can be played.
+//
+// The search plays its moves on the board and evaluator it is given and
+// leaves them as it found them.
+class ThreatSearch {
+  public:
+    // Deepest search, in moves of the attacker.
+    static const int MAX_DEPTH = 12;
+
+  private:
+    Board &board;
+    Evaluator &eval;
+    const int k;
+    // Candidate moves of each ply: ply p owns moveStack[p * numCells] on.
+    std::unique_ptr<int[]> moveStack;
+    std::unique_ptr<bool[]> seen; // marks the cells already in a move list
+    // Cells played since the search started.
+    std::unique_ptr<int[]> line;
+    int lineLength = 0;
+    // Cells of the VCF that makes a three a threat, from the move after the
+    // three to the winning cells.
+    std::unique_ptr<int[]> proof;
+    int proofLength = 0;
+    int proofStart = -1; // where that VCF starts in line, -1 when not looked for
+    long long nodeLimit = 0;
+    int firstMove = -1;
+
+    bool playable(int cell) const;
+    int winSquares(int piece, int *squares) const;
+    int addMove(int *moves, int count, int cell);
+    int addThreatMoves(int piece, bool threes, int *moves, int count);
+    void clearSeen(const int *moves, int count);
+    void play(int cell, int piece);
+    void undo(int cell, int piece);
+    void recordProof(const int *squares, int count);
+    bool attack(int piece, int depth, int ply, bool threes);
+    bool defend(int piece, int depth, int ply);
+
+  public:
+    long long nodes = 0; // positions visited by the last call
+
+    ThreatSearch(Board &board, Evaluator &eval);
+
+    // Looks for a win the side of piece, which is to move, can force in at
+    // most depth of its moves, by fours only or by threes as well. Returns
+    // the first move of the win, or -1 if none turns up within maxNodes
+    // positions.
+    int findWin(int piece, bool threes, int depth, long long maxNodes);
+    // Whether the side of piece has a forced win by threats that the other
+    // side, to move, cannot stop.
+    bool cannotStop(int piece, int depth, long long maxNodes);
+};
+
+#endif // THREATSEARCH_H
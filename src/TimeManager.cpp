@@ -0,0 +1,33 @@
+#include "TimeManager.h"
+#include <algorithm>
+
+namespace {
+const std::chrono::microseconds POLL_PERIOD{100};
+const int MAX_POLL_INTERVAL = 1 << 16;
+} // namespace
+
+void TimeManager::start(std::chrono::milliseconds budget,
+                        std::chrono::milliseconds margin,
+                        Clock::time_point from) {
+    // Never keep back more than half the budget, however small it is.
+    const std::chrono::milliseconds usable =
+        std::max(budget - margin, budget / 2);
+    startTime = from;
+    softStop = from + usable / 2;
+    hardStop = from + usable;
+}
+
+void TimeManager::startUnlimited() {
+    startTime = Clock::now();
+    softStop = Clock::time_point::max();
+    hardStop = Clock::time_point::max();
+}
+
+int TimeManager::adaptPollInterval(int interval, Clock::duration taken) {
+    if (taken < POLL_PERIOD / 2) {
+        return std::min(interval * 2, MAX_POLL_INTERVAL);
+    } else if (taken > POLL_PERIOD * 2) {
+        return std::max(interval / 2, 1);
+    }
+    return interval;
+}
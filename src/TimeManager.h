@@ -0,0 +1,56 @@
+#ifndef TIMEMANAGER_H
+#define TIMEMANAGER_H
+
+#include <atomic>
+#include <chrono>
+
+typedef std::chrono::steady_clock Clock;
+
+// Deadlines for the search of one move, on a monotonic clock.
+//
+// An iteration expected to end past the hard deadline is not started, and
+// neither is one that would end past the soft deadline once the best move has
+// settled; past the hard deadline the search in progress is abandoned. The
+// deadlines can be moved while threads are searching, which is how a
+// pondering search is handed our own clock.
+class TimeManager {
+    std::atomic<Clock::time_point> startTime{Clock::now()};
+    std::atomic<Clock::time_point> softStop{Clock::time_point::max()};
+    std::atomic<Clock::time_point> hardStop{Clock::time_point::max()};
+
+  public:
+    // Starts the clock for a move that has to be made within budget of
+    // from, of which margin is kept back for the reply to reach the shell.
+    void start(std::chrono::milliseconds budget,
+               std::chrono::milliseconds margin,
+               Clock::time_point from = Clock::now());
+    // Starts a search that only stops when told to.
+    void startUnlimited();
+
+    bool softExpired() const { return Clock::now() >= softStop.load(); }
+    // Whether work expected to take duration, started now, would be done
+    // by the soft or the hard deadline.
+    bool fitsSoft(Clock::duration duration) const {
+        return duration <= softStop.load() - Clock::now();
+    }
+    bool fitsHard(Clock::duration duration) const {
+        return duration <= hardStop.load() - Clock::now();
+    }
+    Clock::duration remaining() const {
+        return hardStop.load() - Clock::now();
+    }
+    bool hardExpired(Clock::time_point now) const {
+        return now >= hardStop.load();
+    }
+    std::chrono::milliseconds elapsed() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now() - startTime.load());
+    }
+
+    // Searchers read the clock once every interval nodes. Given how long the
+    // last interval took, returns the next one, so that reads stay about a
+    // tenth of a millisecond apart whatever the node rate.
+    static int adaptPollInterval(int interval, Clock::duration taken);
+};
+
+#endif // TIMEMANAGER_H
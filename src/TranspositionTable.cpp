@@ -0,0 +1,22 @@
+#include "TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(int sizeMb) {
+    if (sizeMb <= 0) {
+        return;
+    }
+    const uint64_t maxSlots = uint64_t(sizeMb) * 1024 * 1024 / sizeof(Slot);
+    numSlots = 1;
+    while (numSlots * 2 <= maxSlots) {
+        numSlots *= 2;
+    }
+    table.reset(new Slot[numSlots]);
+    indexMask = numSlots - 1;
+}
+
+void TranspositionTable::clear() {
+    for (uint64_t i = 0; i < numSlots; i++) {
+        table[i].check.store(0, std::memory_order_relaxed);
+        table[i].data.store(0, std::memory_order_relaxed);
+    }
+    generation = 0;
+}
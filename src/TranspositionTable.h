@@ -0,0 +1,112 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// A search result cached under a position's Zobrist hash.
+struct TTEntry {
+    int16_t score = 0;
+    int16_t move = -1; // cell index of the best move found, or -1.
+    int16_t depth = 0; // remaining search depth the score was found at.
+    uint8_t bound = 0;
+    uint8_t generation = 0;
+};
+
+// Fixed-size, direct-mapped hash table of search results. Entries from older
+// searches or shallower depths are the first to be replaced.
+//
+// The table is shared between search threads without locking: each slot
+// holds the entry packed into one 64-bit word alongside the key XORed with
+// that word, so a slot torn by two concurrent writers fails the key check
+// instead of returning a mix of both entries.
+class TranspositionTable {
+  public:
+    enum Bound : uint8_t { NONE = 0, EXACT, LOWER, UPPER };
+
+  private:
+    struct Slot {
+        std::atomic<uint64_t> check{0}; // key ^ data
+        std::atomic<uint64_t> data{0};
+    };
+
+    std::unique_ptr<Slot[]> table;
+    uint64_t numSlots = 0;
+    uint64_t indexMask = 0;
+    uint8_t generation = 0;
+
+    static uint64_t pack(const TTEntry &entry);
+    static TTEntry unpack(uint64_t data);
+
+  public:
+    // sizeMb is rounded down to a power-of-two number of entries; 0 disables
+    // the table.
+    explicit TranspositionTable(int sizeMb);
+
+    bool enabled() const { return numSlots != 0; }
+    void newSearch() { generation++; }
+    void clear();
+
+    bool probe(uint64_t key, TTEntry &entry) const;
+    void store(uint64_t key, int depth, int score, Bound bound, int move);
+};
+
+inline uint64_t TranspositionTable::pack(const TTEntry &entry) {
+    return uint64_t(uint16_t(entry.score)) |
+           uint64_t(uint16_t(entry.move)) << 16 |
+           uint64_t(uint16_t(entry.depth)) << 32 |
+           uint64_t(entry.bound) << 48 | uint64_t(entry.generation) << 56;
+}
+
+inline TTEntry TranspositionTable::unpack(uint64_t data) {
+    TTEntry entry;
+    entry.score = int16_t(data & 0xFFFF);
+    entry.move = int16_t((data >> 16) & 0xFFFF);
+    entry.depth = int16_t((data >> 32) & 0xFFFF);
+    entry.bound = uint8_t((data >> 48) & 0xFF);
+    entry.generation = uint8_t(data >> 56);
+    return entry;
+}
+
+inline bool TranspositionTable::probe(uint64_t key, TTEntry &entry) const {
+    if (numSlots == 0) {
+        return false;
+    }
+    const Slot &slot = table[key & indexMask];
+    const uint64_t data = slot.data.load(std::memory_order_relaxed);
+    const uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key) {
+        return false;
+    }
+    entry = unpack(data);
+    return entry.bound != NONE;
+}
+
+inline void TranspositionTable::store(uint64_t key, int depth, int score,
+                                      Bound bound, int move) {
+    if (numSlots == 0) {
+        return;
+    }
+    Slot &slot = table[key & indexMask];
+    const uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    const bool sameKey =
+        (slot.check.load(std::memory_order_relaxed) ^ oldData) == key;
+    const TTEntry old = unpack(oldData);
+    if (!sameKey and old.bound != NONE and old.generation == generation and
+        old.depth > depth) {
+        return;
+    }
+
+    TTEntry entry;
+    entry.score = score;
+    entry.move = (move < 0 and sameKey) ? old.move : move;
+    entry.depth = depth;
+    entry.bound = bound;
+    entry.generation = generation;
+    const uint64_t data = pack(entry);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+#endif // TRANSPOSITIONTABLE_H
@@ -0,0 +1,60 @@
+#include "../AIShell.h"
+#include "../Board.h"
+#include "../Searcher.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace std;
+
+namespace {
+atomic<long long> allocations{0};
+} // namespace
+
+// Every heap allocation in the program goes through here.
+void *operator new(size_t size) {
+    allocations++;
+    void *block = malloc(size ? size : 1);
+    if (!block) {
+        throw bad_alloc();
+    }
+    return block;
+}
+
+void operator delete(void *block) noexcept { free(block); }
+
+int main() {
+    // {gravity, cols, rows, k, depth}
+    const int configs[][5] = {{1, 7, 6, 4, 8}, {0, 9, 7, 5, 5}};
+    int failures = 0;
+
+    for (auto &config : configs) {
+        Board board(config[0], config[1], config[2], config[3]);
+        const int centre = board.numCols() / 2;
+        board.place(board.cell(centre, config[0] ? 0 : board.numRows() / 2),
+                    AIShell::OPPONENT_PIECE);
+        SearchOptions options;
+        options.hashSizeMb = 1;
+        options.maxDepth = config[4];
+        TranspositionTable tt(options.hashSizeMb);
+        SearchControl control;
+        control.time.startUnlimited();
+        Searcher searcher(board, options, tt, control);
+
+        const long long before = allocations;
+        searcher.runIDS();
+        const long long searchAllocations = allocations - before;
+        // Move lists, the principal variation and the ordering hint all
+        // live in buffers sized when the searcher is built.
+        if (searcher.depthReached != config[4] or searchAllocations != 0) {
+            cout << "  " << searchAllocations << " allocations in "
+                 << searcher.nodes << " nodes" << endl;
+            failures++;
+        }
+    }
+
+    cout << (failures ? "FAILED" : "passed") << ": search allocations"
+         << endl;
+    return failures ? 1 : 0;
+}
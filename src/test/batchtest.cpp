@@ -0,0 +1,81 @@
+#include "../AIShell.h"
+#include "../Batch.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+// Positions for a depth-limited search: gravity 7x6 k4, without gravity 9x7
+// k5, and our own open three on 7x7 k4, which the search must complete.
+const char *const POSITIONS =
+    "# comment and blank line\n"
+    "\n"
+    "1 7 6 4 6 0 1 0 0 0 0 0  -1 0 0 0 0 0  0 0 0 0 0 0  1 -1 1 0 0 0  "
+    "0 0 0 0 0 0  -1 0 0 0 0 0  0 0 0 0 0 0\n"
+    "0 9 7 5 4 0 "
+    "0 0 0 0 0 0 0  0 0 0 0 0 0 0  0 0 1 -1 0 0 0  0 0 0 1 0 0 0  "
+    "0 0 -1 1 -1 0 0  0 0 0 0 0 0 0  0 0 0 0 0 0 0  0 0 0 0 0 0 0  "
+    "0 0 0 0 0 0 0\n"
+    "0 7 7 4 3 0 0 0 0 0 0 0 0  0 0 0 0 0 0 0  0 0 0 1 0 -1 0  "
+    "0 0 0 1 0 -1 0  0 0 0 1 0 -1 0  0 0 0 0 0 0 0  0 0 0 0 0 0 0\n";
+
+bool sameSearch(const BatchResult &a, const BatchResult &b) {
+    return a.report.move == b.report.move and
+           a.report.score == b.report.score and
+           a.report.depth == b.report.depth and
+           a.report.nodes == b.report.nodes;
+}
+} // namespace
+
+int main() {
+    int failures = 0;
+
+    istringstream in(POSITIONS);
+    vector<BatchPosition> positions;
+    string error;
+    failures += !readBatch(in, positions, error) or positions.size() != 3;
+
+    SearchOptions options;
+    options.hashSizeMb = 4;
+    options.solveCells = 0;
+    // One worker or three, every position gets the same search, and the
+    // results come out in order.
+    ostringstream out;
+    const vector<BatchResult> alone = runBatch(positions, options, 1);
+    const vector<BatchResult> shared = runBatch(positions, options, 3, &out);
+    for (size_t i = 0; i < positions.size() and alone.size() == 3 and
+                       shared.size() == 3;
+         i++) {
+        failures += !sameSearch(alone[i], shared[i]);
+    }
+    istringstream lines(out.str());
+    string line;
+    for (int i = 0; getline(lines, line); i++) {
+        failures += line.compare(0, 2, to_string(i) + "\t") != 0;
+    }
+    failures += alone.size() != 3 or alone[0].report.depth != 6 or
+                alone[1].report.depth != 4 or
+                alone[2].report.score != Searcher::MAXWIN or
+                (alone[2].report.move != Move(1, 3) and
+                 alone[2].report.move != Move(5, 3));
+
+    // Malformed and finished positions are refused with their line.
+    const char *const bad[] = {
+        "1 7 6 4 6 0 1 0\n",             // too few cells
+        "0 3 3 3 0 0 0 0 0 0 0 0 0 0 0\n", // no limit
+        "0 3 3 3 2 0 1 1 1 0 0 0 0 0 0\n", // already won
+        "1 3 3 3 2 0 0 1 0 0 0 0 0 0 0\n", // piece in the air
+        "\n0 3 3 3 2 0 0 0 0 0 2 0 0 0 0\n"};
+    for (const char *text : bad) {
+        istringstream badIn(text);
+        vector<BatchPosition> none;
+        failures += readBatch(badIn, none, error);
+    }
+    failures += error.compare(0, 7, "line 2:") != 0;
+
+    cout << (failures ? "FAILED" : "passed") << ": batch analysis" << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+#include "../AIShell.h"
+#include "../Board.h"
+#include "../BoardShape.h"
+#include "../Frontier.h"
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+namespace {
+// Brute-force k in a row check.
+bool hasWin(const Board &board, int piece) {
+    const int colStep[] = {0, 1, 1, 1};
+    const int rowStep[] = {1, 0, 1, -1};
+    for (int dir = 0; dir < 4; dir++) {
+        for (int col = 0; col < board.numCols(); col++) {
+            for (int row = 0; row < board.numRows(); row++) {
+                int length = 0;
+                for (int x = col, y = row;
+                     x < board.numCols() and y >= 0 and y < board.numRows() and
+                     board.pieceAt(x, y) == piece;
+                     x += colStep[dir], y += rowStep[dir]) {
+                    length++;
+                }
+                if (length >= board.k()) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void randomFill(Board &board, mt19937 &rng) {
+    const int pieces = rng() % (board.numCells() / 2 + 1);
+    for (int i = 0; i < pieces; i++) {
+        const int col = rng() % board.numCols();
+        int row = rng() % board.numRows();
+        if (board.gravityOn()) {
+            if (!board.colHasSpace(col)) {
+                continue;
+            }
+            row = board.height(col);
+        } else if (!board.isEmpty(col, row)) {
+            continue;
+        }
+        board.place(board.cell(col, row),
+                    (i % 2) ? AIShell::OPPONENT_PIECE : AIShell::PLAYER_PIECE);
+    }
+}
+
+// Checks the line tests of Shape against Board on random positions.
+template <class Shape> int shapeFailures(mt19937 &rng) {
+    const Shape &shape = Shape::get();
+    int failures = 0;
+    for (int trial = 0; trial < 200; trial++) {
+        Board board(Shape::gravityOn(), Shape::numCols(), Shape::numRows(),
+                    Shape::k());
+        randomFill(board, rng);
+        for (int piece : {AIShell::PLAYER_PIECE, AIShell::OPPONENT_PIECE}) {
+            const uint64_t mask = board.mask(piece)[0];
+            failures += shape.hasLine(mask) != board.hasWin(piece);
+            if (board.hasWin(piece)) {
+                continue;
+            }
+            for (int cell = 0; cell < board.numCells(); cell++) {
+                if (!board.isEmpty(cell)) {
+                    continue;
+                }
+                board.place(cell, piece);
+                const bool wins = (shape.winningCells(mask) >> cell) & 1;
+                failures += wins != board.hasWin(piece);
+                board.remove(cell, piece);
+            }
+        }
+    }
+    return failures;
+}
+
+// Brute-force check that an empty cell has a piece within reach.
+bool nearPiece(const Board &board, int cell, int reach) {
+    const int col = board.colOf(cell), row = board.rowOf(cell);
+    for (int x = col - reach; x <= col + reach; x++) {
+        for (int y = row - reach; y <= row + reach; y++) {
+            if (x >= 0 and x < board.numCols() and y >= 0 and
+                y < board.numRows() and !board.isEmpty(x, y)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Checks the frontier against a full scan as pieces are placed and taken
+// back in stack order, the way the search does.
+int frontierFailures(Board &board, int reach, mt19937 &rng) {
+    Frontier frontier(board, reach);
+    vector<int> placed;
+    int failures = 0;
+    for (int step = 0; step < 2 * board.numCells(); step++) {
+        const int cell = rng() % board.numCells();
+        if (board.isEmpty(cell) and rng() % 3) {
+            board.place(cell, (step % 2) ? AIShell::OPPONENT_PIECE
+                                         : AIShell::PLAYER_PIECE);
+            frontier.place(cell);
+            placed.push_back(cell);
+        } else if (!placed.empty()) {
+            board.remove(placed.back(), board.pieceAt(placed.back()));
+            frontier.remove(placed.back());
+            placed.pop_back();
+        }
+        vector<int> listed(board.numCells());
+        listed.resize(frontier.list(listed.data()));
+        vector<int> expected;
+        for (int c = 0; c < board.numCells(); c++) {
+            if (board.isEmpty(c) and nearPiece(board, c, reach)) {
+                expected.push_back(c);
+            }
+        }
+        failures += listed != expected;
+    }
+    return failures;
+}
+} // namespace
+
+int main() {
+    const int configs[][4] = {{1, 7, 6, 4},  {1, 9, 7, 5}, {0, 9, 7, 5},
+                              {0, 7, 7, 5},  {0, 3, 3, 3}, {0, 40, 20, 6},
+                              {1, 30, 30, 5}, {0, 64, 16, 5}, {1, 64, 1, 4}};
+    mt19937 rng(2);
+    int winFailures = 0, hashFailures = 0, frontierFails = 0;
+
+    for (auto &config : configs) {
+        for (int trial = 0; trial < 200; trial++) {
+            Board board(config[0], config[1], config[2], config[3]);
+            randomFill(board, rng);
+            if (!config[0] and trial % 20 == 0) {
+                Board start = board;
+                frontierFails += frontierFailures(start, 1 + trial % 3, rng);
+            }
+
+            for (int piece : {AIShell::PLAYER_PIECE, AIShell::OPPONENT_PIECE}) {
+                if (board.hasWin(piece) != hasWin(board, piece)) {
+                    winFailures++;
+                }
+            }
+
+            // Every symmetric copy of the position has the same canonical
+            // hash, and mapping a cell there and back is the identity.
+            int symmetry;
+            const uint64_t canonical = board.canonicalHash(symmetry);
+            for (int s = 0; s < board.numSymmetries(); s++) {
+                Board copy(config[0], config[1], config[2], config[3]);
+                for (int cell = 0; cell < board.numCells(); cell++) {
+                    if (!board.isEmpty(cell)) {
+                        copy.place(board.transformCell(cell, s),
+                                   board.pieceAt(cell));
+                    }
+                    if (board.inverseTransformCell(
+                            board.transformCell(cell, s), s) != cell) {
+                        hashFailures++;
+                    }
+                }
+                int copySymmetry;
+                if (copy.canonicalHash(copySymmetry) != canonical) {
+                    hashFailures++;
+                }
+            }
+        }
+    }
+
+    winFailures += shapeFailures<BoardShape<7, 6, 4, true>>(rng);
+    winFailures += shapeFailures<BoardShape<9, 7, 5, true>>(rng);
+    winFailures += shapeFailures<BoardShape<9, 7, 5, false>>(rng);
+
+    // The largest boards fit, one more column or cell does not, and a line
+    // through the last cell of the largest is found.
+    int sizeFailures = !Board::fits(Board::MAX_COLS, 16) or
+                       !Board::fits(1, Board::MAX_CELLS) or
+                       Board::fits(Board::MAX_COLS + 1, 1) or
+                       Board::fits(32, 33) or Board::fits(0, 6) or
+                       Board::fits(2, 1 << 30);
+    Board largest(false, Board::MAX_COLS, 16, 5);
+    for (int col = Board::MAX_COLS - 5; col < Board::MAX_COLS; col++) {
+        largest.place(largest.cell(col, 15), AIShell::OPPONENT_PIECE);
+    }
+    sizeFailures += !largest.hasWin(AIShell::OPPONENT_PIECE) or
+                    largest.hasWin(AIShell::PLAYER_PIECE);
+
+    cout << (winFailures ? "FAILED" : "passed") << ": bitboard win detection"
+         << endl;
+    cout << (hashFailures ? "FAILED" : "passed") << ": symmetric position keys"
+         << endl;
+    cout << (frontierFails ? "FAILED" : "passed") << ": incremental move frontier"
+         << endl;
+    cout << (sizeFailures ? "FAILED" : "passed") << ": board size limits"
+         << endl;
+    return (winFailures or hashFailures or frontierFails or sizeFailures) ? 1
+                                                                          : 0;
+}
@@ -0,0 +1,146 @@
+#include "../AIShell.h"
+#include "../Board.h"
+#include "../Evaluator.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+// The scalar path: cell by cell along every line, counting the runs of
+// cells each side has to itself (possible wins) and fills (wins).
+int scalarEval(const Board &board) {
+    const int colStep[] = {0, 1, 1, 1};
+    const int rowStep[] = {1, 0, 1, -1};
+    const int k = board.k();
+    int wins[2] = {0, 0}, possibleWins[2] = {0, 0};
+    for (int dir = 0; dir < 4; dir++) {
+        for (int col = 0; col < board.numCols(); col++) {
+            for (int row = 0; row < board.numRows(); row++) {
+                // Start only at the first cell of each line.
+                const int prevCol = col - colStep[dir];
+                const int prevRow = row - rowStep[dir];
+                if (prevCol >= 0 and prevRow >= 0 and
+                    prevRow < board.numRows()) {
+                    continue;
+                }
+                int open[2] = {0, 0}, run[2] = {0, 0};
+                for (int x = col, y = row;
+                     x < board.numCols() and y >= 0 and y < board.numRows();
+                     x += colStep[dir], y += rowStep[dir]) {
+                    const int piece = board.pieceAt(x, y);
+                    for (int side = 0; side < 2; side++) {
+                        const int own = side ? AIShell::OPPONENT_PIECE
+                                             : AIShell::PLAYER_PIECE;
+                        open[side] = piece == -own ? 0 : open[side] + 1;
+                        run[side] = piece == own ? run[side] + 1 : 0;
+                        possibleWins[side] += open[side] >= k;
+                        wins[side] += run[side] >= k;
+                    }
+                }
+            }
+        }
+    }
+    if (wins[1]) {
+        return -1000;
+    } else if (wins[0]) {
+        return 1000;
+    }
+    return possibleWins[0] - possibleWins[1];
+}
+
+int scanEval(const Board &board) {
+    int maxWins, maxPossibleWins, minWins, minPossibleWins;
+    board.countWindows(AIShell::PLAYER_PIECE, maxWins, maxPossibleWins);
+    board.countWindows(AIShell::OPPONENT_PIECE, minWins, minPossibleWins);
+    if (minWins) {
+        return -1000;
+    } else if (maxWins) {
+        return 1000;
+    }
+    return maxPossibleWins - minPossibleWins;
+}
+
+// Nanoseconds per call of evaluate over positions, and the sum of its
+// results, which keeps the calls from being optimized away.
+template <typename F>
+double timePerPosition(const vector<Board> &positions, F evaluate,
+                       long long &sum) {
+    const int rounds = 200;
+    const auto start = steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (auto &board : positions) {
+            sum += evaluate(board);
+        }
+    }
+    const double ns =
+        duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    return ns / (rounds * positions.size());
+}
+} // namespace
+
+// Compares the scalar line scan with the bit-parallel window count, and
+// with the cost of the incremental Evaluator's update for one move, with
+// and without pattern scoring.
+int main() {
+    const int configs[][4] = {{1, 7, 6, 4}, {0, 9, 7, 5}, {0, 19, 19, 5}};
+    mt19937 rng(5);
+
+    for (auto &config : configs) {
+        vector<Board> positions;
+        for (int i = 0; i < 1000; i++) {
+            Board board(config[0], config[1], config[2], config[3]);
+            const int pieces = rng() % (board.numCells() / 2);
+            for (int p = 0; p < pieces; p++) {
+                const int cell = rng() % board.numCells();
+                if (board.isEmpty(cell)) {
+                    board.place(cell, (p % 2) ? AIShell::OPPONENT_PIECE
+                                              : AIShell::PLAYER_PIECE);
+                }
+            }
+            positions.push_back(board);
+        }
+
+        long long scalarSum = 0, scanSum = 0;
+        const double scalar =
+            timePerPosition(positions, scalarEval, scalarSum);
+        const double scan = timePerPosition(positions, scanEval, scanSum);
+        // One move and its take-back on each empty cell of a position, by
+        // the evaluator counting possible wins and by the one scoring
+        // patterns.
+        vector<int> cells;
+        for (int cell = 0; cell < positions[0].numCells(); cell++) {
+            if (positions[0].isEmpty(cell)) {
+                cells.push_back(cell);
+            }
+        }
+        double incremental[2];
+        long long incrementalSum = 0;
+        for (int patterns = 0; patterns < 2; patterns++) {
+            Evaluator eval(positions[0], patterns);
+            int next = 0;
+            incremental[patterns] = timePerPosition(
+                positions,
+                [&](const Board &) {
+                    const int cell = cells[next++ % cells.size()];
+                    eval.place(cell, AIShell::PLAYER_PIECE);
+                    const int score =
+                        eval.maxPossibleWins() + eval.patternScore();
+                    eval.remove(cell, AIShell::PLAYER_PIECE);
+                    return score;
+                },
+                incrementalSum);
+        }
+
+        cout << config[1] << "x" << config[2] << " k" << config[3]
+             << (config[0] ? " gravity" : "") << ": scalar " << scalar
+             << " ns, bitboard " << scan << " ns, incremental move "
+             << incremental[0] << " ns (" << incremental[1]
+             << " ns with patterns)"
+             << (scalarSum == scanSum ? "" : " (results differ)") << endl;
+    }
+    return 0;
+}
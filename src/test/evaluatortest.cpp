@@ -0,0 +1,197 @@
+#include "../AIShell.h"
+#include "../Board.h"
+#include "../Evaluator.h"
+#include "../Patterns.h"
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+struct Totals {
+    int maxPossibleWins = 0, minPossibleWins = 0, maxWins = 0, minWins = 0;
+};
+
+// Brute-force count over every k-window of the board.
+Totals countWindows(const Board &board) {
+    const int colStep[] = {0, 1, 1, 1};
+    const int rowStep[] = {1, 0, 1, -1};
+    const int k = board.k();
+    Totals totals;
+    for (int dir = 0; dir < 4; dir++) {
+        for (int col = 0; col < board.numCols(); col++) {
+            for (int row = 0; row < board.numRows(); row++) {
+                int player = 0, opponent = 0, length = 0;
+                for (int x = col, y = row;
+                     length < k and x < board.numCols() and y >= 0 and
+                     y < board.numRows();
+                     x += colStep[dir], y += rowStep[dir], length++) {
+                    player += board.pieceAt(x, y) == AIShell::PLAYER_PIECE;
+                    opponent += board.pieceAt(x, y) == AIShell::OPPONENT_PIECE;
+                }
+                if (length < k) {
+                    continue;
+                }
+                totals.maxPossibleWins += opponent == 0;
+                totals.minPossibleWins += player == 0;
+                totals.maxWins += player == k;
+                totals.minWins += opponent == k;
+            }
+        }
+    }
+    return totals;
+}
+
+bool matches(const Evaluator &eval, const Board &board) {
+    const Totals expected = countWindows(board);
+    return eval.maxPossibleWins() == expected.maxPossibleWins and
+           eval.minPossibleWins() == expected.minPossibleWins and
+           eval.maxWins() == expected.maxWins and
+           eval.minWins() == expected.minWins;
+}
+
+// Pattern score of the board, line by line from the tables.
+int patternScore(const Board &board) {
+    const Patterns &patterns = Patterns::forK(board.k());
+    const int colStep[] = {0, 1, 1, 1};
+    const int rowStep[] = {1, 0, 1, -1};
+    int score = 0;
+    for (int length : {board.k(), board.k() + 1}) {
+        for (int dir = 0; dir < 4; dir++) {
+            for (int col = 0; col < board.numCols(); col++) {
+                for (int row = 0; row < board.numRows(); row++) {
+                    uint32_t code = 0;
+                    int i = 0;
+                    for (int x = col, y = row;
+                         i < length and x < board.numCols() and y >= 0 and
+                         y < board.numRows();
+                         x += colStep[dir], y += rowStep[dir], i++) {
+                        if (!board.isEmpty(x, y)) {
+                            code += Patterns::digit(board.pieceAt(x, y)) *
+                                    Patterns::power(i);
+                        }
+                    }
+                    if (i == length) {
+                        score += length == board.k()
+                                     ? patterns.window(code).score
+                                     : patterns.frame(code);
+                    }
+                }
+            }
+        }
+    }
+    return score;
+}
+
+// Empty cells where piece would make k in a row.
+int threatCells(Board &board, int piece) {
+    int cells = 0;
+    for (int cell = 0; cell < board.numCells(); cell++) {
+        if (board.isEmpty(cell)) {
+            board.place(cell, piece);
+            cells += board.hasWin(piece);
+            board.remove(cell, piece);
+        }
+    }
+    return cells;
+}
+
+bool patternsMatch(const Evaluator &eval, Board &board) {
+    return eval.patternScore() == patternScore(board) and
+           eval.threatCellsOf(AIShell::PLAYER_PIECE) ==
+               threatCells(board, AIShell::PLAYER_PIECE) and
+           eval.threatCellsOf(AIShell::OPPONENT_PIECE) ==
+               threatCells(board, AIShell::OPPONENT_PIECE);
+}
+
+bool scanMatches(const Board &board) {
+    const Totals expected = countWindows(board);
+    Totals totals;
+    board.countWindows(AIShell::PLAYER_PIECE, totals.maxWins,
+                       totals.maxPossibleWins);
+    board.countWindows(AIShell::OPPONENT_PIECE, totals.minWins,
+                       totals.minPossibleWins);
+    return totals.maxPossibleWins == expected.maxPossibleWins and
+           totals.minPossibleWins == expected.minPossibleWins and
+           totals.maxWins == expected.maxWins and
+           totals.minWins == expected.minWins;
+}
+} // namespace
+
+int main() {
+    const int configs[][4] = {{1, 7, 6, 4}, {1, 9, 7, 5}, {0, 9, 7, 5},
+                              {0, 3, 3, 3}, {0, 4, 9, 5}, {0, 11, 11, 6},
+                              {0, 40, 20, 6}};
+    mt19937 rng(1);
+    int failures = 0;
+
+    for (auto &config : configs) {
+        Board board(config[0], config[1], config[2], config[3]);
+        Evaluator eval(board);
+        vector<pair<int, int>> played;
+
+        for (int step = 0; step < 2000; step++) {
+            const bool full = int(played.size()) == board.numCells();
+            const bool undo = !played.empty() and (full or rng() % 3 == 0);
+            if (undo) {
+                board.remove(played.back().first, played.back().second);
+                eval.remove(played.back().first, played.back().second);
+                played.pop_back();
+            } else {
+                int cell;
+                do {
+                    cell = rng() % board.numCells();
+                } while (!board.isEmpty(cell));
+                const int piece = (played.size() % 2) ? AIShell::OPPONENT_PIECE
+                                                      : AIShell::PLAYER_PIECE;
+                board.place(cell, piece);
+                eval.place(cell, piece);
+                played.push_back({cell, piece});
+            }
+            if (!matches(eval, board) or !scanMatches(board)) {
+                failures++;
+                break;
+            }
+        }
+
+        // A fresh evaluator must pick up the pieces already on the board.
+        if (!matches(Evaluator(board), board)) {
+            failures++;
+        }
+    }
+
+    // The pattern evaluator, on boards without a win: a board filled up far
+    // enough always has one, and then a window can be past a four.
+    for (auto &config : configs) {
+        Board board(config[0], config[1], config[2], config[3]);
+        Evaluator eval(board, true);
+        vector<pair<int, int>> played;
+        for (int step = 0; step < 1000; step++) {
+            int cell;
+            do {
+                cell = rng() % board.numCells();
+            } while (!board.isEmpty(cell));
+            const int piece = (played.size() % 2) ? AIShell::OPPONENT_PIECE
+                                                  : AIShell::PLAYER_PIECE;
+            board.place(cell, piece);
+            eval.place(cell, piece);
+            played.push_back({cell, piece});
+            const bool over = board.hasWin(piece) or
+                              int(played.size()) == board.numCells();
+            if (over or rng() % 3 == 0) {
+                board.remove(cell, piece);
+                eval.remove(cell, piece);
+                played.pop_back();
+            }
+            if (!patternsMatch(eval, board)) {
+                failures++;
+                break;
+            }
+        }
+    }
+
+    cout << (failures ? "FAILED" : "passed") << ": evaluator window counts"
+         << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+#include "../Match.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+const char *const OPENINGS = "# comment and blank line\n"
+                             "\n"
+                             "1 7 6 4 3 0 3 1\n"
+                             "0 9 7 5 4 3 5 3 4 4\n"
+                             "1 5 4 4\n";
+
+bool sameGames(const MatchResult &a, const MatchResult &b) {
+    if (a.games.size() != b.games.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.games.size(); i++) {
+        if (a.games[i].result != b.games[i].result or
+            a.games[i].moves != b.games[i].moves or
+            a.games[i].opening != b.games[i].opening) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Plays two games against a program, with moveTimeMs to move, and returns
+// how many the engine won with end as the reason.
+int winsAgainst(const char *command, const char *end, int moveTimeMs = 0) {
+    MatchPlayer engine;
+    engine.options.hashSizeMb = 1;
+    engine.options.maxDepth = 2;
+    MatchPlayer program;
+    program.command = command;
+    MatchSettings settings;
+    settings.games = 2;
+    settings.moveTimeMs = moveTimeMs;
+    const MatchResult result = runMatch(
+        engine, program, randomOpenings({MatchRules()}, 1, 2, 7), settings);
+    int wins = 0;
+    for (const GameRecord &game : result.games) {
+        wins += game.result == 1 and strcmp(game.end, end) == 0;
+    }
+    return wins;
+}
+} // namespace
+
+int main() {
+    int failures = 0;
+
+    failures += eloDifference(0.5) != 0 or
+                fabs(eloDifference(0.75) - 190.85) > 0.01 or
+                !isinf(eloDifference(1));
+    MatchResult even;
+    even.wins = even.losses = 30;
+    even.draws = 40;
+    failures += even.elo() != 0 or even.eloError() < 40 or
+                even.eloError() > 70;
+    MatchResult sweep;
+    sweep.wins = 10;
+    failures += !isinf(sweep.elo()) or !isinf(sweep.eloError());
+
+    istringstream in(OPENINGS);
+    vector<MatchOpening> openings;
+    string error;
+    failures += !readOpenings(in, openings, error) or openings.size() != 3 or
+                openings[1].moves.size() != 3 or
+                openings[1].rules.gravityOn or openings[2].rules.k != 4;
+    const char *const bad[] = {
+        "1 7 6 4 3 1\n",                  // piece in the air
+        "0 3 3 3 0 0 0 0\n",              // taken cell
+        "0 3 3 3 0 0 1 0 0 1 1 1 0 2\n",  // already won
+        "1 7 6 4 3\n",                    // half a move
+        "\n0 7 6 9\n"};                   // k too long
+    for (const char *text : bad) {
+        istringstream badIn(text);
+        vector<MatchOpening> none;
+        failures += readOpenings(badIn, none, error);
+    }
+    failures += error.compare(0, 7, "line 2:") != 0;
+
+    // Random openings are legal and the same for the same seed.
+    vector<MatchRules> rules(2);
+    rules[1].gravityOn = false;
+    const vector<MatchOpening> random = randomOpenings(rules, 6, 4, 3);
+    ostringstream text;
+    for (const MatchOpening &opening : random) {
+        const MatchRules &r = opening.rules;
+        text << r.gravityOn << ' ' << r.numCols << ' ' << r.numRows << ' '
+             << r.k;
+        for (const Move &move : opening.moves) {
+            text << ' ' << move.col << ' ' << move.row;
+        }
+        text << '\n';
+        failures += opening.moves.size() != 4;
+    }
+    istringstream randomIn(text.str());
+    vector<MatchOpening> reread;
+    failures += !readOpenings(randomIn, reread, error) or
+                reread.size() != 6 or
+                reread[1].rules.gravityOn != rules[1].gravityOn;
+    failures +=
+        randomOpenings(rules, 6, 4, 3)[5].moves[3] != random[5].moves[3];
+
+    // A deeper search beats a shallower one, and the games come out the same
+    // on any number of workers.
+    MatchPlayer deep;
+    deep.options.hashSizeMb = 1;
+    deep.options.maxDepth = 5;
+    MatchPlayer shallow = deep;
+    shallow.options.maxDepth = 1;
+    MatchSettings settings;
+    settings.games = 8;
+    settings.moveTimeMs = 0;
+    const vector<MatchOpening> gravity =
+        randomOpenings({MatchRules()}, 4, 2, 1);
+    ostringstream out;
+    const MatchResult alone = runMatch(deep, shallow, gravity, settings);
+    settings.workers = 3;
+    const MatchResult shared =
+        runMatch(deep, shallow, gravity, settings, &out);
+    failures += alone.played() != 8 or !sameGames(alone, shared) or
+                alone.wins <= alone.losses or alone.engine.searched == 0 or
+                alone.engine.depths > 5 * alone.engine.searched or
+                alone.opponent.depths > alone.opponent.searched;
+    istringstream lines(out.str());
+    string line;
+    for (int i = 0; getline(lines, line); i++) {
+        failures += line.compare(0, to_string(i).size() + 1,
+                                 to_string(i) + "\t") != 0;
+    }
+
+    // A program loses on an illegal move, on none at all, or when it does not
+    // answer in time; what it writes before its answer is skipped.
+    failures += winsAgainst("echo banner; while read request; do "
+                            "echo ReturningTheMoveMade 0 5; done",
+                            "illegal") != 2;
+    failures += winsAgainst("exit 0", "no move") != 2;
+    failures += winsAgainst("while read request; do :; done", "time", 50) != 2;
+
+    cout << (failures ? "FAILED" : "passed") << ": self-play match" << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+#include "../AIShell.h"
+#include "../Board.h"
+#include "../MonteCarlo.h"
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+// Searches the root of mcts for ms milliseconds.
+int searchFor(MonteCarlo &mcts, SearchControl &control, int ms) {
+    control.outOfTime = false;
+    control.time.start(chrono::milliseconds(ms), chrono::milliseconds(0));
+    return mcts.search();
+}
+} // namespace
+
+int main() {
+    const int player = AIShell::PLAYER_PIECE;
+    const int opponent = AIShell::OPPONENT_PIECE;
+    int failures = 0;
+
+    for (int threads = 1; threads <= 2; threads++) {
+        SearchOptions options;
+        options.threads = threads;
+        options.mctsMb = 4;
+
+        // Our own three in a row on 7x7 k4: the fourth wins at once.
+        {
+            Board board(false, 7, 7, 4);
+            SearchControl control;
+            for (int col = 2; col <= 4; col++) {
+                board.place(board.cell(col, 3), player);
+                board.place(board.cell(col, 5), opponent);
+            }
+            MonteCarlo mcts(board, options, control);
+            const int cell = searchFor(mcts, control, 50);
+            failures += cell != board.cell(1, 3) and cell != board.cell(5, 3);
+        }
+
+        // The opponent threatens to complete a line closed at one end, which
+        // only the playouts can see to block.
+        {
+            Board board(false, 7, 7, 4);
+            SearchControl control;
+            board.place(board.cell(0, 1), opponent);
+            board.place(board.cell(1, 1), opponent);
+            board.place(board.cell(2, 1), opponent);
+            board.place(board.cell(6, 6), player);
+            board.place(board.cell(4, 5), player);
+            MonteCarlo mcts(board, options, control);
+            failures += searchFor(mcts, control, 200) != board.cell(3, 1);
+        }
+
+        // A move and the reply to it keep the tree under them.
+        {
+            Board board(false, 9, 7, 5);
+            SearchControl control;
+            board.place(board.cell(4, 3), opponent);
+            MonteCarlo mcts(board, options, control);
+            const int cell = searchFor(mcts, control, 100);
+            mcts.playMove(cell, player);
+            failures += mcts.rootVisits() == 0;
+            mcts.playMove(board.cell(4, 4) == cell ? board.cell(3, 3)
+                                                   : board.cell(4, 4),
+                          opponent);
+            failures += mcts.rootVisits() == 0 or mcts.treeSize() < 2;
+        }
+    }
+
+    cout << (failures ? "FAILED" : "passed") << ": Monte Carlo tree search"
+         << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+#include "../Match.h"
+#include "../Searcher.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+// Calls of each function timed on each position.
+static const int ROUNDS = 100;
+// Where the results go, so that the calls are not optimized away.
+volatile long long sink;
+} // namespace
+
+// Times the work of a node of the search, its static evaluation, its move
+// generation and playing and taking back a move, over legal positions of
+// random moves at several stages of the game.
+int main() {
+    const int configs[][4] = {
+        {1, 7, 6, 4}, {1, 9, 7, 5}, {0, 9, 7, 5}, {0, 19, 19, 5}};
+    SearchOptions options;
+    options.hashSizeMb = 0;
+    TranspositionTable tt(options.hashSizeMb);
+    SearchControl control;
+
+    for (auto &config : configs) {
+        MatchRules rules;
+        rules.gravityOn = config[0];
+        rules.numCols = config[1];
+        rules.numRows = config[2];
+        rules.k = config[3];
+        vector<MatchOpening> positions;
+        for (int plies : {4, 12, 24}) {
+            for (auto &opening :
+                 randomOpenings({rules}, 200, plies, 5 + plies)) {
+                positions.push_back(opening);
+            }
+        }
+
+        nanoseconds evalTime{0}, movesTime{0}, placeTime{0};
+        long long sum = 0;
+        long long moves = 0;
+        long long placements = 0;
+        for (auto &position : positions) {
+            Board board(rules.gravityOn, rules.numCols, rules.numRows,
+                        rules.k);
+            int piece = AIShell::PLAYER_PIECE;
+            for (const Move &move : position.moves) {
+                board.place(board.cell(move.col, move.row), piece);
+                piece = -piece;
+            }
+            Searcher searcher(board, options, tt, control);
+
+            auto start = steady_clock::now();
+            for (int round = 0; round < ROUNDS; round++) {
+                sum += searcher.rootEval();
+            }
+            evalTime += steady_clock::now() - start;
+            start = steady_clock::now();
+            for (int round = 0; round < ROUNDS; round++) {
+                sum += searcher.rootMoves();
+            }
+            movesTime += steady_clock::now() - start;
+            moves += searcher.rootMoves();
+            start = steady_clock::now();
+            for (int round = 0; round < ROUNDS; round++) {
+                placements += searcher.rootPlacements();
+            }
+            placeTime += steady_clock::now() - start;
+        }
+        sink = sum;
+
+        const double calls = double(ROUNDS) * positions.size();
+        cout << config[1] << "x" << config[2] << " k" << config[3]
+             << (config[0] ? " gravity" : "") << ": staticEval "
+             << evalTime.count() / calls << " ns, findMoves "
+             << movesTime.count() / calls << " ns ("
+             << double(moves) / positions.size() << " moves), place "
+             << placeTime.count() / double(placements) << " ns" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "../AIShell.h"
+#include "../Board.h"
+#include "../ProofSearch.h"
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+namespace {
+bool playable(const Board &board, int cell) {
+    return board.isEmpty(cell) and
+           (!board.gravityOn() or
+            board.height(board.colOf(cell)) == board.rowOf(cell));
+}
+
+// Brute force: 1 if the side of piece, to move, wins, 0 for a draw and -1
+// if it loses.
+int solve(Board &board, int piece, int alpha, int beta) {
+    int best = -2;
+    for (int cell = 0; cell < board.numCells() and alpha < beta; cell++) {
+        if (!playable(board, cell)) {
+            continue;
+        }
+        board.place(cell, piece);
+        const int score =
+            board.hasWin(piece) ? 1 : -solve(board, -piece, -beta, -alpha);
+        board.remove(cell, piece);
+        best = max(best, score);
+        alpha = max(alpha, best);
+    }
+    return best == -2 ? 0 : best;
+}
+
+bool randomPosition(Board &board, int pieces, mt19937 &rng) {
+    for (int i = 0; i < pieces; i++) {
+        int cell;
+        do {
+            cell = rng() % board.numCells();
+        } while (!playable(board, cell));
+        const int piece = ((pieces - i) % 2) ? AIShell::OPPONENT_PIECE
+                                             : AIShell::PLAYER_PIECE;
+        board.place(cell, piece);
+        if (board.hasWin(piece)) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int main() {
+    // {gravity, cols, rows, k, pieces already placed}
+    const int configs[][5] = {{0, 3, 3, 3, 0}, {0, 3, 3, 3, 3},
+                              {0, 4, 4, 3, 8}, {1, 4, 4, 3, 6}};
+    const int player = AIShell::PLAYER_PIECE;
+    mt19937 rng(4);
+    int failures = 0;
+
+    for (auto &config : configs) {
+        for (int trial = 0; trial < 50; trial++) {
+            Board board(config[0], config[1], config[2], config[3]);
+            if (!randomPosition(board, config[4], rng)) {
+                continue;
+            }
+            ProofSearch solver(board, 1);
+            int move = -1;
+            const ProofSearch::Result result =
+                solver.solve(board, Clock::time_point::max(), move);
+            const int value = solve(board, player, -1, 1);
+            const ProofSearch::Result expected =
+                value > 0 ? ProofSearch::WIN
+                          : value < 0 ? ProofSearch::LOSS : ProofSearch::DRAW;
+            if (result != expected or move < 0 or !playable(board, move)) {
+                failures++;
+                continue;
+            }
+            // The move has to keep the value the solver promised.
+            board.place(move, player);
+            const int after =
+                board.hasWin(player) ? 1 : -solve(board, -player, -1, 1);
+            if (value >= 0 and after != value) {
+                failures++;
+            }
+        }
+    }
+
+    cout << (failures ? "FAILED" : "passed") << ": proof-number solver"
+         << endl;
+    return failures ? 1 : 0;
+}
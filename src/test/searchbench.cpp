@@ -0,0 +1,176 @@
+#include "../AIShell.h"
+#include "../Batch.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+// Total nodes of the fixed-depth searches. A change that is not meant to
+// change the search has to leave it as it is; one that is has to update it.
+static const long long SIGNATURE = 11367255;
+// Plies below each position's depth that the thread sweep searches to.
+static const int SWEEP_PLIES = 2;
+
+// Positions from engine games, in the batch format: gravity cols rows k
+// depth ms cells. Each is searched to its depth, and again for its time.
+struct BenchPosition {
+    const char *name;
+    const char *line;
+};
+
+const BenchPosition POSITIONS[] = {
+    {"7x6 k4 gravity opening",
+     "1 7 6 4 16 500  0 0 0 0 0 0  0 0 0 0 0 0  1 0 0 0 0 0  1 -1 0 0 0 0  "
+     "-1 0 0 0 0 0  0 0 0 0 0 0  0 0 0 0 0 0"},
+    {"7x6 k4 gravity middle",
+     "1 7 6 4 16 500  0 0 0 0 0 0  1 -1 1 -1 0 0  -1 1 -1 0 0 0  "
+     "1 1 -1 1 -1 1  0 0 0 0 0 0  -1 0 0 0 0 0  0 0 0 0 0 0"},
+    {"7x6 k4 gravity endgame",
+     "1 7 6 4 16 500  -1 0 0 0 0 0  -1 1 1 -1 -1 1  1 -1 1 -1 1 0  "
+     "1 -1 1 -1 1 -1  1 0 0 0 0 0  -1 1 -1 1 -1 1  -1 0 0 0 0 0"},
+    {"9x7 k5 gravity opening",
+     "1 9 7 5 14 500  0 0 0 0 0 0 0  0 0 0 0 0 0 0  -1 0 0 0 0 0 0  "
+     "0 0 0 0 0 0 0  0 0 0 0 0 0 0  1 1 -1 0 0 0 0  0 0 0 0 0 0 0  "
+     "0 0 0 0 0 0 0  0 0 0 0 0 0 0"},
+    {"9x7 k5 gravity middle",
+     "1 9 7 5 16 500  0 0 0 0 0 0 0  1 -1 1 -1 1 -1 1  0 0 0 0 0 0 0  "
+     "-1 1 -1 1 -1 1 -1  1 -1 1 -1 1 -1 1  0 0 0 0 0 0 0  -1 0 0 0 0 0 0  "
+     "1 0 0 0 0 0 0  -1 0 0 0 0 0 0"},
+    {"9x7 k5 gravity endgame",
+     "1 9 7 5 18 500  -1 1 -1 1 -1 1 -1  1 0 0 0 0 0 0  -1 1 -1 0 0 0 0  "
+     "-1 1 -1 1 -1 0 0  1 -1 1 -1 1 -1 1  1 1 -1 1 -1 1 -1  "
+     "-1 1 -1 1 -1 1 0  1 -1 1 -1 0 0 0  1 -1 1 -1 0 0 0"},
+    {"9x7 k5 opening",
+     "0 9 7 5 7 500  0 0 0 0 0 0 0  0 0 0 0 0 0 0  0 0 0 0 0 0 0  "
+     "0 1 0 0 -1 0 0  0 0 0 0 1 0 0  0 0 0 -1 0 0 0  0 0 0 0 0 0 0  "
+     "0 0 0 0 0 0 0  0 0 0 0 0 0 0"},
+    {"9x7 k5 middle",
+     "0 9 7 5 8 500  0 0 0 0 0 0 0  0 0 0 0 0 1 0  0 0 -1 1 0 0 0  "
+     "0 1 0 0 -1 0 0  1 -1 0 0 1 -1 -1  0 0 1 -1 0 0 0  -1 0 0 0 0 1 0  "
+     "0 0 0 0 0 0 0  0 0 0 0 0 0 0"},
+    {"9x7 k5 endgame",
+     "0 9 7 5 9 500  0 0 1 -1 0 0 0  1 0 -1 0 0 1 0  0 0 -1 1 0 0 0  "
+     "0 1 0 0 -1 0 1  1 -1 -1 -1 1 -1 -1  0 0 1 -1 0 0 0  "
+     "-1 0 1 -1 0 1 0  0 0 -1 1 0 0 0  0 1 0 0 -1 0 1"},
+};
+
+long long nodesPerSecond(const BatchResult &result) {
+    return result.report.nodes * 1000 / max(result.timeMs, 1LL);
+}
+
+string moveText(const Move &move) {
+    return "(" + to_string(move.col) + ", " + to_string(move.row) + ")";
+}
+
+void writeTable(const char *title, const vector<BatchResult> &results) {
+    cout << left << setw(26) << title << right << setw(6) << "depth"
+         << setw(10) << "move" << setw(12) << "nodes" << setw(9) << "ms"
+         << setw(12) << "nodes/s" << endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const BatchResult &result = results[i];
+        cout << left << setw(26) << POSITIONS[i].name << right << setw(6)
+             << result.report.depth << setw(10)
+             << moveText(result.report.move) << setw(12)
+             << result.report.nodes << setw(9) << result.timeMs << setw(12)
+             << nodesPerSecond(result) << endl;
+    }
+}
+
+long long totalMs(const vector<BatchResult> &results) {
+    long long ms = 0;
+    for (const BatchResult &result : results) {
+        ms += result.timeMs;
+    }
+    return ms;
+}
+
+// Searches positions with 1, 2, 4 and one thread per core, with Lazy SMP and
+// with YBW, and reports the time to their depths and the speedup over one
+// thread.
+void writeSweep(const vector<BatchPosition> &positions,
+                const SearchOptions &options) {
+    vector<int> counts = {1, 2, 4, int(thread::hardware_concurrency())};
+    sort(counts.begin(), counts.end());
+    counts.erase(unique(counts.begin(), counts.end()), counts.end());
+    counts.erase(counts.begin(), upper_bound(counts.begin(), counts.end(), 0));
+
+    const string title = "threads, depth - " + to_string(SWEEP_PLIES);
+    cout << left << setw(26) << title << right << setw(12)
+         << "lazy ms" << setw(9) << "speedup" << setw(12) << "ybw ms"
+         << setw(9) << "speedup" << endl;
+    long long oneThreadMs[2] = {0, 0};
+    for (int count : counts) {
+        cout << left << setw(26) << count << right << fixed
+             << setprecision(2);
+        for (int ybw = 0; ybw < 2; ybw++) {
+            SearchOptions own = options;
+            own.threads = count;
+            own.ybw = ybw;
+            const long long ms = max(totalMs(runBatch(positions, own, 1)), 1LL);
+            if (count == 1) {
+                oneThreadMs[ybw] = ms;
+            }
+            cout << setw(12) << ms << setw(9)
+                 << double(oneThreadMs[ybw]) / ms;
+        }
+        cout << endl;
+        cout.unsetf(ios::floatfield);
+    }
+}
+} // namespace
+
+// Searches the positions on one thread with the default options, except
+// for a smaller table and no solver (which would take over the endgames),
+// first to a fixed depth and then for a fixed time, then a little shallower
+// on more threads.
+int main() {
+    vector<BatchPosition> positions;
+    for (auto &position : POSITIONS) {
+        istringstream in(position.line);
+        string error;
+        if (!readBatch(in, positions, error)) {
+            cout << position.name << ": " << error << endl;
+            return 1;
+        }
+    }
+    SearchOptions options;
+    options.hashSizeMb = 16;
+    options.solveCells = 0;
+
+    vector<BatchPosition> byDepth = positions, byTime = positions;
+    for (size_t i = 0; i < positions.size(); i++) {
+        byDepth[i].timeMs = 0;
+        byTime[i].depth = 0;
+    }
+    vector<BatchPosition> sweep = byDepth;
+    for (BatchPosition &position : sweep) {
+        position.depth = max(position.depth - SWEEP_PLIES, 1);
+    }
+    const vector<BatchResult> depthResults = runBatch(byDepth, options, 1);
+    const vector<BatchResult> timeResults = runBatch(byTime, options, 1);
+
+    writeTable("fixed depth", depthResults);
+    cout << endl;
+    writeTable("fixed time", timeResults);
+    cout << endl;
+    writeSweep(sweep, options);
+
+    long long signature = 0;
+    for (const BatchResult &result : depthResults) {
+        signature += result.report.nodes;
+    }
+    cout << endl << "signature " << signature;
+    if (signature != SIGNATURE) {
+        cout << ", expected " << SIGNATURE << ": the search has changed"
+             << endl;
+        return 1;
+    }
+    cout << endl;
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "../AIShell.h"
+#include "../Board.h"
+#include "../Evaluator.h"
+#include "../ThreatSearch.h"
+#include <iostream>
+#include <random>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+bool playable(const Board &board, int cell) {
+    return board.isEmpty(cell) and
+           (!board.gravityOn() or
+            board.height(board.colOf(cell)) == board.rowOf(cell));
+}
+
+// Brute force: 1 if the side of piece, to move, can force a win within
+// depth plies, -1 if the other side can, 0 otherwise.
+int solve(Board &board, int piece, int depth, int alpha, int beta) {
+    if (depth == 0) {
+        return 0;
+    }
+    int best = -1;
+    bool anyMove = false;
+    for (int cell = 0; cell < board.numCells() and alpha < beta; cell++) {
+        if (!playable(board, cell)) {
+            continue;
+        }
+        anyMove = true;
+        board.place(cell, piece);
+        const int score = board.hasWin(piece)
+                              ? 1
+                              : -solve(board, -piece, depth - 1, -beta,
+                                       -alpha);
+        board.remove(cell, piece);
+        best = max(best, score);
+        alpha = max(alpha, best);
+    }
+    return anyMove ? best : 0;
+}
+
+// Positions, in the batch format without depth and ms, where a three of
+// the player's looked like a win by threats of up to 3 moves, but a stone
+// of the opponent's off its proof makes a four with a block forced later.
+const char *const OFF_PROOF[] = {
+    "1 7 6 4  1 0 0 0 0 0  1 0 0 0 0 0  -1 1 0 0 0 0  -1 0 0 0 0 0  "
+    "-1 1 -1 0 0 0  1 -1 0 0 0 0  -1 0 0 0 0 0",
+    "1 7 6 4  1 -1 0 0 0 0  1 -1 0 0 0 0  0 0 0 0 0 0  -1 1 1 -1 -1 0  "
+    "1 1 0 0 0 0  -1 1 -1 0 0 0  -1 -1 -1 1 1 0"};
+
+// Up to 20 random pieces, or none if that gives someone a line already.
+bool randomPosition(Board &board, mt19937 &rng) {
+    const int pieces = 6 + rng() % 15;
+    for (int i = 0; i < pieces; i++) {
+        int cell;
+        do {
+            cell = rng() % board.numCells();
+            if (board.gravityOn()) {
+                const int col = board.colOf(cell);
+                cell = board.colHasSpace(col)
+                           ? board.cell(col, board.height(col))
+                           : cell;
+            }
+        } while (!playable(board, cell));
+        const int piece =
+            (i % 2) ? AIShell::PLAYER_PIECE : AIShell::OPPONENT_PIECE;
+        board.place(cell, piece);
+        if (board.hasWin(piece)) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int main() {
+    // {gravity, cols, rows, k, depth in moves of the attacker}
+    const int configs[][5] = {{1, 7, 6, 4, 3}, {0, 7, 7, 4, 2}};
+    const int player = AIShell::PLAYER_PIECE;
+    mt19937 rng(3);
+    int proofs = 0, failures = 0;
+
+    for (auto &config : configs) {
+        const int depth = config[4];
+        for (int trial = 0; trial < 100; trial++) {
+            Board board(config[0], config[1], config[2], config[3]);
+            if (!randomPosition(board, rng)) {
+                continue;
+            }
+            Evaluator eval(board);
+            ThreatSearch threats(board, eval);
+            const uint64_t hash = board.hash();
+
+            // A win in depth threats takes at most 2 * depth + 1 plies, and
+            // a loss after our move at most 2 * depth - 1 more.
+            const int win = threats.findWin(player, true, depth, 100000);
+            const bool lost =
+                win < 0 and threats.cannotStop(-player, depth - 1, 100000);
+            if (board.hash() != hash) {
+                failures++;
+                continue;
+            }
+            if (win >= 0) {
+                proofs++;
+                board.place(win, player);
+                if (!board.hasWin(player) and
+                    solve(board, -player, 2 * depth, -1, 1) != -1) {
+                    failures++;
+                }
+            } else if (lost) {
+                proofs++;
+                if (solve(board, player, 2 * depth, -1, 1) != -1) {
+                    failures++;
+                }
+            }
+        }
+    }
+
+    // No win within the 7 plies a win by 3 threats takes, and none claimed.
+    for (const char *text : OFF_PROOF) {
+        istringstream in(text);
+        int gravity, cols, rows, k;
+        in >> gravity >> cols >> rows >> k;
+        Board board(gravity, cols, rows, k);
+        for (int cell = 0; cell < board.numCells(); cell++) {
+            int piece;
+            in >> piece;
+            if (piece) {
+                board.place(cell, piece);
+            }
+        }
+        Evaluator eval(board);
+        ThreatSearch threats(board, eval);
+        failures += solve(board, player, 7, -1, 1) == 1 or
+                    threats.findWin(player, true, 3, 100000) >= 0;
+    }
+
+    if (proofs == 0) {
+        failures++;
+    }
+    cout << (failures ? "FAILED" : "passed") << ": threat search proofs"
+         << endl;
+    return failures ? 1 : 0;
+}